@@ -0,0 +1,153 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "Aggregate_Kernels.h"
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FINANCIAL_TRANSACTIONS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace aggregate {
+
+static_assert(sizeof(Money) == sizeof(std::int64_t));
+static_assert(sizeof(TransactionKind) == 1);
+
+namespace {
+
+// Risultato parziale in centesimi: si combina fra il corpo vettoriale e la coda
+struct Partial {
+    std::int64_t deposits = 0;
+    std::int64_t withdrawals = 0;   // somma dei valori negativi (<= 0)
+    std::size_t withdrawalCount = 0;
+    std::int64_t min = std::numeric_limits<std::int64_t>::max();
+    std::int64_t max = std::numeric_limits<std::int64_t>::min();
+};
+
+void scalarRange(const Money* amounts, const TransactionKind* kinds, std::size_t from, std::size_t to,
+                 const std::uint32_t* groups, Money* groupTotals, Partial& p) {
+    for (std::size_t i = from; i < to; ++i) {
+        // Negazione senza salti: mask = -1 per le Expense, 0 altrimenti
+        const std::int64_t mask = -static_cast<std::int64_t>(kinds[i] == TransactionKind::Expense);
+        const std::int64_t v = (amounts[i].cents() ^ mask) - mask;
+        const bool negative = v < 0;
+        p.deposits += negative ? 0 : v;
+        p.withdrawals += negative ? v : 0;
+        p.withdrawalCount += negative;
+        p.min = std::min(p.min, v);
+        p.max = std::max(p.max, v);
+        if (groups) groupTotals[groups[i]] += Money::fromCents(v);
+    }
+}
+
+#if defined(FINANCIAL_TRANSACTIONS_AVX2)
+__attribute__((target("avx2")))
+std::int64_t horizontalSum(__m256i v) {
+    alignas(32) std::int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// 4 righe per iterazione: 32 byte di importi + 4 byte di tipi
+__attribute__((target("avx2")))
+std::size_t avx2Range(const Money* amounts, const TransactionKind* kinds, std::size_t n,
+                      const std::uint32_t* groups, Money* groupTotals, Partial& p) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i deposits = zero, withdrawals = zero, negatives = zero;
+    __m256i min = _mm256_set1_epi64x(p.min), max = _mm256_set1_epi64x(p.max);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(amounts + i));
+        std::uint32_t k4;
+        std::memcpy(&k4, kinds + i, sizeof(k4));
+        const __m256i mask = _mm256_sub_epi64(zero, _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(static_cast<int>(k4))));
+        const __m256i v = _mm256_sub_epi64(_mm256_xor_si256(a, mask), mask);
+
+        const __m256i negative = _mm256_cmpgt_epi64(zero, v);
+        deposits = _mm256_add_epi64(deposits, _mm256_andnot_si256(negative, v));
+        withdrawals = _mm256_add_epi64(withdrawals, _mm256_and_si256(negative, v));
+        negatives = _mm256_sub_epi64(negatives, negative);
+        min = _mm256_blendv_epi8(min, v, _mm256_cmpgt_epi64(min, v));
+        max = _mm256_blendv_epi8(max, v, _mm256_cmpgt_epi64(v, max));
+
+        if (groups) {
+            alignas(32) std::int64_t values[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(values), v);
+            for (int j = 0; j < 4; ++j) groupTotals[groups[i + j]] += Money::fromCents(values[j]);
+        }
+    }
+
+    alignas(32) std::int64_t lanes[4];
+    p.deposits += horizontalSum(deposits);
+    p.withdrawals += horizontalSum(withdrawals);
+    p.withdrawalCount += static_cast<std::size_t>(horizontalSum(negatives));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), min);
+    p.min = std::min({p.min, lanes[0], lanes[1], lanes[2], lanes[3]});
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), max);
+    p.max = std::max({p.max, lanes[0], lanes[1], lanes[2], lanes[3]});
+    return i;
+}
+#endif
+
+void checkSizes(std::span<const Money> amounts, std::span<const TransactionKind> kinds,
+                std::span<const std::uint32_t> groups) {
+    if (kinds.size() != amounts.size() || (!groups.empty() && groups.size() != amounts.size())) {
+        throw std::invalid_argument("aggregate: column sizes differ");
+    }
+}
+
+Totals finish(const Partial& p, std::size_t rows) {
+    Totals t;
+    t.deposits = Money::fromCents(p.deposits);
+    t.withdrawals = Money::fromCents(-p.withdrawals);
+    t.balance = Money::fromCents(p.deposits + p.withdrawals);
+    t.withdrawalCount = p.withdrawalCount;
+    t.depositCount = rows - p.withdrawalCount;
+    if (rows > 0) {
+        t.minValue = Money::fromCents(p.min);
+        t.maxValue = Money::fromCents(p.max);
+    }
+    return t;
+}
+
+}
+
+bool avx2Enabled() {
+#if defined(FINANCIAL_TRANSACTIONS_AVX2)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+Totals summarizeScalar(std::span<const Money> amounts, std::span<const TransactionKind> kinds,
+                       std::span<const std::uint32_t> groups, std::span<Money> groupTotals) {
+    checkSizes(amounts, kinds, groups);
+    Partial p;
+    scalarRange(amounts.data(), kinds.data(), 0, amounts.size(),
+                groups.empty() ? nullptr : groups.data(), groupTotals.data(), p);
+    return finish(p, amounts.size());
+}
+
+Totals summarize(std::span<const Money> amounts, std::span<const TransactionKind> kinds,
+                 std::span<const std::uint32_t> groups, std::span<Money> groupTotals) {
+    checkSizes(amounts, kinds, groups);
+    const std::uint32_t* g = groups.empty() ? nullptr : groups.data();
+    Partial p;
+    std::size_t done = 0;
+#if defined(FINANCIAL_TRANSACTIONS_AVX2)
+    if (avx2Enabled()) {
+        done = avx2Range(amounts.data(), kinds.data(), amounts.size(), g, groupTotals.data(), p);
+    }
+#endif
+    scalarRange(amounts.data(), kinds.data(), done, amounts.size(), g, groupTotals.data(), p);
+    return finish(p, amounts.size());
+}
+
+}
@@ -0,0 +1,42 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_AGGREGATE_KERNELS_H
+#define FINANCIAL_TRANSACTIONS_AGGREGATE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "Money.h"
+#include "Transaction_Store.h"
+
+// Aggregazioni in una sola passata sulle colonne importo + tipo dello store.
+// Valore con segno di una riga: importo, negato per le Expense (come getValue()).
+// La versione AVX2 viene scelta a runtime se la CPU la supporta; i risultati
+// sono identici a quelli scalari (somme intere, ordine irrilevante).
+namespace aggregate {
+
+struct Totals {
+    Money deposits;             // somma dei valori >= 0
+    Money withdrawals;          // somma dei valori < 0, cambiata di segno
+    Money balance;
+    std::size_t depositCount = 0;
+    std::size_t withdrawalCount = 0;
+    Money minValue;             // zero se non ci sono righe
+    Money maxValue;
+};
+
+// Se groups non è vuoto (stessa lunghezza di amounts) il valore di ogni riga
+// viene sommato anche in groupTotals[groups[i]], che va dimensionato dal chiamante
+Totals summarize(std::span<const Money> amounts, std::span<const TransactionKind> kinds,
+                 std::span<const std::uint32_t> groups = {}, std::span<Money> groupTotals = {});
+Totals summarizeScalar(std::span<const Money> amounts, std::span<const TransactionKind> kinds,
+                       std::span<const std::uint32_t> groups = {}, std::span<Money> groupTotals = {});
+
+bool avx2Enabled();
+
+}
+
+
+#endif //FINANCIAL_TRANSACTIONS_AGGREGATE_KERNELS_H
@@ -0,0 +1,131 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include "Balance_Index.h"
+
+std::uint32_t BalanceIndex::priorityOf(std::size_t row) {
+    // splitmix64: priorità pseudo-casuali ma deterministiche (stesso albero a ogni rebuild)
+    std::uint64_t z = static_cast<std::uint64_t>(row) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<std::uint32_t>((z ^ (z >> 31)) >> 32);
+}
+
+void BalanceIndex::pull(std::uint32_t n) {
+    Node& node = nodes[n];
+    Sums s;
+    if (node.value >= Money{}) s.deposits = node.value;
+    else                       s.withdrawals = -node.value;
+    for (const std::uint32_t child : {node.left, node.right}) {
+        if (child == kNil) continue;
+        s.deposits += nodes[child].subtree.deposits;
+        s.withdrawals += nodes[child].subtree.withdrawals;
+    }
+    node.subtree = s;
+}
+
+void BalanceIndex::split(std::uint32_t t, std::uint32_t key, std::uint32_t& left, std::uint32_t& right) {
+    if (t == kNil) {
+        left = right = kNil;
+        return;
+    }
+    if (before(t, key)) {
+        split(nodes[t].right, key, nodes[t].right, right);
+        left = t;
+    } else {
+        split(nodes[t].left, key, left, nodes[t].left);
+        right = t;
+    }
+    pull(t);
+}
+
+std::uint32_t BalanceIndex::insert(std::uint32_t t, std::uint32_t n) {
+    if (t == kNil) return n;
+    if (nodes[n].priority > nodes[t].priority) {
+        split(t, n, nodes[n].left, nodes[n].right);
+        pull(n);
+        return n;
+    }
+    if (before(n, t)) nodes[t].left = insert(nodes[t].left, n);
+    else              nodes[t].right = insert(nodes[t].right, n);
+    pull(t);
+    return t;
+}
+
+void BalanceIndex::add(TimePoint when, std::size_t row, Money value) {
+    const auto n = static_cast<std::uint32_t>(nodes.size());
+    nodes.push_back(Node{when, static_cast<std::uint32_t>(row), priorityOf(row), kNil, kNil, value, {}});
+    pull(n);
+    root = insert(root, n);
+}
+
+void BalanceIndex::rebuild(const TransactionStore& store) {
+    clear();
+    const auto order = store.rowsByTime();
+    nodes.reserve(order.size());
+    const auto dates = store.timestamps();
+    const auto amounts = store.amounts();
+    const auto kinds = store.kinds();
+
+    // Chiavi già in ordine: il ramo destro vive sullo stack, un nodo viene chiuso
+    // (pull) quando esce dallo stack, dopo i suoi figli
+    std::vector<std::uint32_t> stack;
+    for (const std::uint32_t row : order) {
+        const auto n = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back(Node{dates[row], row, priorityOf(row), kNil, kNil,
+                             signedValue(kinds[row], amounts[row]), {}});
+        std::uint32_t last = kNil;
+        while (!stack.empty() && nodes[stack.back()].priority < nodes[n].priority) {
+            last = stack.back();
+            stack.pop_back();
+            pull(last);
+        }
+        nodes[n].left = last;
+        if (!stack.empty()) nodes[stack.back()].right = n;
+        stack.push_back(n);
+    }
+    // In fondo allo stack resta la priorità massima: la radice
+    root = stack.empty() ? kNil : stack.front();
+    while (!stack.empty()) {
+        pull(stack.back());
+        stack.pop_back();
+    }
+}
+
+void BalanceIndex::clear() {
+    nodes.clear();
+    root = kNil;
+}
+
+BalanceIndex::Sums BalanceIndex::prefix(TimePoint t, bool inclusive) const {
+    Sums s;
+    std::uint32_t n = root;
+    while (n != kNil) {
+        const Node& node = nodes[n];
+        if (node.when < t || (inclusive && node.when == t)) {
+            // Il nodo e tutto il suo sottoalbero sinistro stanno prima di t
+            if (node.left != kNil) {
+                s.deposits += nodes[node.left].subtree.deposits;
+                s.withdrawals += nodes[node.left].subtree.withdrawals;
+            }
+            if (node.value >= Money{}) s.deposits += node.value;
+            else                       s.withdrawals += -node.value;
+            n = node.right;
+        } else {
+            n = node.left;
+        }
+    }
+    return s;
+}
+
+BalanceIndex::Sums BalanceIndex::through(TimePoint t) const {
+    return prefix(t, true);
+}
+
+BalanceIndex::Sums BalanceIndex::between(TimePoint from, TimePoint to) const {
+    if (to <= from) return {};
+    const Sums upper = prefix(to, false);
+    const Sums lower = prefix(from, false);
+    return Sums{upper.deposits - lower.deposits, upper.withdrawals - lower.withdrawals};
+}
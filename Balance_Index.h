@@ -0,0 +1,74 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_BALANCE_INDEX_H
+#define FINANCIAL_TRANSACTIONS_BALANCE_INDEX_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "Transaction_Store.h"
+
+// Somme prefisso nel tempo: treap ordinato per (timestamp, riga) in cui ogni nodo
+// tiene entrate e uscite del proprio sottoalbero. Inserimento (anche fuori ordine)
+// e somma fino a un istante in O(log n) attesi; ricostruzione da store in O(n).
+class BalanceIndex {
+public:
+    struct Sums {
+        Money deposits;
+        Money withdrawals;
+        Money balance() const {
+            return deposits - withdrawals;
+        }
+    };
+
+    explicit BalanceIndex(std::pmr::memory_resource* mr = std::pmr::get_default_resource()) : nodes(mr) {}
+
+    void add(TimePoint when, std::size_t row, Money value);
+    void add(const TransactionView& t) {
+        add(t.getData(), t.row(), t.getValue());
+    }
+    // Dall'ordine temporale dello store (già ordinato): albero cartesiano con uno stack
+    void rebuild(const TransactionStore& store);
+    void clear();
+
+    // Transazioni con timestamp <= t
+    Sums through(TimePoint t) const;
+    // Transazioni con timestamp in [from, to)
+    Sums between(TimePoint from, TimePoint to) const;
+
+    std::size_t size() const {
+        return nodes.size();
+    }
+
+private:
+    static constexpr std::uint32_t kNil = UINT32_MAX;
+
+    struct Node {
+        TimePoint when;
+        std::uint32_t row;
+        std::uint32_t priority;
+        std::uint32_t left = kNil;
+        std::uint32_t right = kNil;
+        Money value;
+        Sums subtree;
+    };
+
+    std::pmr::vector<Node> nodes;
+    std::uint32_t root = kNil;
+
+    static std::uint32_t priorityOf(std::size_t row);
+    bool before(std::uint32_t a, std::uint32_t b) const {
+        return nodes[a].when < nodes[b].when || (nodes[a].when == nodes[b].when && nodes[a].row < nodes[b].row);
+    }
+    void pull(std::uint32_t n);
+    // Divide t in (chiavi < key) e (chiavi >= key)
+    void split(std::uint32_t t, std::uint32_t key, std::uint32_t& left, std::uint32_t& right);
+    std::uint32_t insert(std::uint32_t t, std::uint32_t n);
+    // Somme delle transazioni con timestamp < t (inclusive: <= t)
+    Sums prefix(TimePoint t, bool inclusive) const;
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_BALANCE_INDEX_H
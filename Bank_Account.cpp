@@ -1,95 +1,149 @@
 //
 // Created by Andrea Peli on 15/11/25.
 #include <algorithm>
+#include <array>
 #include <ranges>
-#include <format>
-#include <fstream>
 #include <iostream>
+#include <filesystem>
 #include <stdexcept>
-#include <iomanip>
-#include <sstream>
-#include <array>
-#include "Expense.h"
-#include "Income.h"
+#include <unordered_map>
+#include <unordered_set>
 #include "Bank_Account.h"
-
-// --- Supporto data/ora
-
-static TimePoint parseDateTime(const std::string& s) {
-    std::tm tm{};
-    std::istringstream iss(s);
-    iss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-    if (iss.fail()) {
-        throw std::runtime_error("Invalid datetime format: " + s);
-    }
-    // Converte ora locale in time_t
-    std::time_t tt = std::mktime(&tm);
-    if (tt == -1) {
-        throw std::runtime_error("mktime failed for: " + s);
+#include "Csv_Reader.h"
+#include "Csv_Writer.h"
+#include "Journal.h"
+#include "Mapped_File.h"
+#include "Snapshot.h"
+
+std::vector<TransactionRow> BankAccount::getSortedTransactions() const {
+    ReadLock lock(*this);
+    // Lo store è già in ordine temporale: nessun sort
+    std::vector<TransactionRow> sorted;
+    sorted.reserve(transactions.size());
+    for (const auto row : transactions.rowsByTime()) {
+        sorted.emplace_back(transactions, row);
     }
-    // Converte a time_point
-    return Clock::from_time_t(tt);
+    return sorted;
 }
 
-std::vector<const Transaction*> BankAccount::getSortedTransactions() const {
-    std::vector<const Transaction*> sorted;
-    sorted.reserve(transactions.size());
-    for (const auto& t : transactions) {
-        sorted.push_back(t.get());
+std::vector<TransactionRow> BankAccount::between(TimePoint from, TimePoint to) const {
+    ReadLock lock(*this);
+    const auto rows = transactions.rowsBetween(from, to);
+    std::vector<TransactionRow> out;
+    out.reserve(rows.size());
+    for (const auto row : rows) {
+        out.emplace_back(transactions, row);
     }
-    std::ranges::sort(sorted, std::ranges::less{}, &Transaction::getData);
-    return sorted;
+    return out;
 }
 
 BankAccount::Summary BankAccount::computeSummary() const {
-    Summary summary{};
-    summary.balance = balance();
-    for (const auto* t : getSortedTransactions()) {
-        const double val = t->getValue();
-        if (val >= 0) summary.deposits += val;
-        else          summary.withdrawals += -val;
-    }
-    return summary;
-}
-
-static void printTransaction(const Transaction& t) {
-    std::cout << std::format(
-        "ID: {}\n"
-        "Date: {}\n"
-        "Amount: {:.2f}\n"
-        "Operation: {}\n"
-        "Category: {}\n"
-        "Description: {}\n"
-        "Sender: {}\n"
-        "Receiver: {}\n\n",
-        t.getId(),
-        t.getDataFormatted().substr(0, 19),
-        t.getAmount(),
-        t.getOperationType(),
-        t.getCategory(),
-        t.getDescription(),
-        t.getSenderAccount(),
-        t.getReceiverAccount()
-    );
+    ReadLock lock(*this);
+    return totals;
+}
+
+void BankAccount::accumulate(const TransactionView& t) {
+    const Money val = t.getValue();
+    if (val >= Money{}) totals.deposits += val;
+    else                totals.withdrawals += -val;
+    totals.balance += val;
+    rollupIndex.add(t);
+    balanceIndex.add(t);
+}
+
+void BankAccount::resetTotals() {
+    totals = Summary{};
+    rollupIndex.clear();
+    balanceIndex.clear();
+}
+
+void BankAccount::recomputeTotals() {
+    const auto t = aggregate::summarize(transactions.amounts(), transactions.kinds());
+    totals = Summary{t.deposits, t.withdrawals, t.balance};
+    rollupIndex.rebuild(transactions);
+    balanceIndex.rebuild(transactions);
+}
+
+Money BankAccount::balanceAt(TimePoint t) const {
+    ReadLock lock(*this);
+    return balanceIndex.through(t).balance();
+}
+
+BankAccount::Summary BankAccount::summaryBetween(TimePoint from, TimePoint to) const {
+    ReadLock lock(*this);
+    const auto s = balanceIndex.between(from, to);
+    return Summary{s.deposits, s.withdrawals, s.balance()};
+}
+
+std::vector<Rollup> BankAccount::rollups(RollupPeriod period, TimePoint from, TimePoint to) const {
+    ReadLock lock(*this);
+    return rollupIndex.buckets(period, from, to);
+}
+
+std::vector<CategoryRollup> BankAccount::categoryTotals(TimePoint from, TimePoint to) const {
+    ReadLock lock(*this);
+    return rollupIndex.byCategory(from, to);
+}
+
+BankAccount::Statistics BankAccount::computeStatistics() const {
+    ReadLock lock(*this);
+    const StringDictionary& dictionary = StringDictionary::shared();
+    const auto amounts = transactions.amounts();
+    const auto kinds = transactions.kinds();
+    const auto categories = transactions.categoryCodes();
+    Statistics stats;
+    stats.totals = aggregate::summarize(amounts, kinds);
+
+    // Il dizionario condiviso contiene anche conti e controparti di tutto il processo:
+    // le somme si indicizzano con slot densi delle sole categorie del conto, tradotti
+    // a blocchi e passati allo stesso kernel
+    std::unordered_map<std::uint32_t, std::uint32_t> slotOf;
+    std::vector<std::uint32_t> codeOf;
+    std::vector<Money> sums;
+    std::array<std::uint32_t, 4096> slots;
+    for (std::size_t first = 0; first < categories.size(); first += slots.size()) {
+        const std::size_t n = std::min(slots.size(), categories.size() - first);
+        std::uint32_t lastCode = UINT32_MAX, lastSlot = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::uint32_t code = categories[first + i];
+            if (code != lastCode) {
+                const auto [it, inserted] = slotOf.try_emplace(code, static_cast<std::uint32_t>(codeOf.size()));
+                if (inserted) {
+                    codeOf.push_back(code);
+                    sums.emplace_back();
+                }
+                lastCode = code;
+                lastSlot = it->second;
+            }
+            slots[i] = lastSlot;
+        }
+        aggregate::summarize(amounts.subspan(first, n), kinds.subspan(first, n), std::span(slots).first(n), sums);
+    }
+    for (std::size_t slot = 0; slot < codeOf.size(); ++slot) {
+        stats.byCategory.emplace_back(std::string(dictionary[codeOf[slot]]), sums[slot]);
+    }
+    std::ranges::sort(stats.byCategory, {}, &std::pair<std::string, Money>::first);
+    return stats;
 }
 
 template <typename Pred>
 void BankAccount::printFiltered(const std::string& pwd, Pred predicate) const {
     requireAuth(pwd);
-    std::vector<const Transaction*> filtered;
-    for (const auto& t : transactions) {
-        if (predicate(*t)) {
-            filtered.push_back(t.get());
+    StreamSink sink(std::cout);
+    ReportRenderer out(sink);
+    std::vector<std::uint32_t> rows;
+    std::uint64_t seen;
+    {
+        ReadLock lock(*this);
+        // Scansione in ordine temporale: il risultato esce già ordinato
+        for (const auto row : transactions.rowsByTime()) {
+            if (predicate(transactions[row])) rows.push_back(row);
         }
+        seen = generation;
     }
-    if (filtered.empty()) {
-        std::cout << "No transactions found\n";
-        return;
-    }
-    std::ranges::sort(filtered, std::ranges::less{}, &Transaction::getData);
-    for (const auto* t : filtered) {
-        printTransaction(*t);
-    }
+    renderRows(out, rows, seen);
+    if (out.rowCount() == 0) out.noResults();
+    out.flush();
 }
 
 void BankAccount::validateTransfer(const BankAccount* destinationAccount) const {
@@ -102,27 +156,172 @@ void BankAccount::validateTransfer(const BankAccount* destinationAccount) const
     }
 }
 
-void BankAccount::addTransaction(std::unique_ptr<Transaction> t,
-                                 const BankAccount* destinationAccount) {
+void BankAccount::checkRules(Money currentBalance, TransactionKind kind, Money value, bool transfer,
+                             const BankAccount* destinationAccount) const {
     // Regole per i trasferimenti:
     // Non si possono effettuare spese se supera la soglia del saldo presete nel conto
-    if (t->getType() == "Expense" && balance()+ t->getValue() <0 ){
+    if (kind == TransactionKind::Expense && currentBalance + value < Money{}) {
         throw std::runtime_error("Insufficient balance");
     }
     // deve esserci un destinatario
-    if (t->getCategory() == "Transfer") {
+    if (transfer) {
         validateTransfer(destinationAccount);
     }
-    // Nota: non viene controllata la duplicazione degli ID, si assume che siano unici
-    transactions.push_back(std::move(t));
 }
 
-double BankAccount::balance() const {
-    double total = 0.0;
-    for (const auto& t : transactions) {
-        total += t->getValue();
+std::uint64_t BankAccount::commitRow(std::size_t row) {
+    const TransactionView t = transactions[row];
+    // Prima il journal, poi i totali: se il record viene rifiutato la riga sparisce
+    std::uint64_t lsn = 0;
+    if (journal) {
+        try {
+            lsn = journal->append(t.record());
+        } catch (...) {
+            transactions.truncate(row);
+            throw;
+        }
+    }
+    accumulate(t);
+    return lsn;
+}
+
+void BankAccount::waitJournal(const std::shared_ptr<TransactionJournal>& j, std::uint64_t lsn,
+                              std::size_t row, const std::string& id) {
+    // Fuori dal lock: gli scrittori concorrenti si accodano e condividono la fdatasync
+    if (!j || lsn == 0) return;
+    try {
+        j->waitDurable(lsn);
+    } catch (...) {
+        discardFrom(row, id);
+        throw;
+    }
+}
+
+void BankAccount::discardFrom(std::size_t row, const std::string& id) {
+    WriteLock lock(*this);
+    // Già tolta da chi ha fallito prima, o conto ricaricato nel frattempo
+    if (row >= transactions.size() || transactions.id(row) != id) return;
+    // Il journal in errore non accetta altro: anche le righe successive non sono durevoli
+    transactions.truncate(row);
+    ++generation;
+    recomputeTotals();
+}
+
+void BankAccount::addTransaction(std::unique_ptr<Transaction> t,
+                                 const BankAccount* destinationAccount) {
+    std::shared_ptr<TransactionJournal> j;
+    std::uint64_t lsn = 0;
+    std::size_t row;
+    {
+        WriteLock lock(*this);
+        checkRules(totals.balance, t->kind(), t->value(),
+                   t->getCategoryCode() == StringDictionary::kTransfer, destinationAccount);
+        // ID duplicati rifiutati dallo store (indice hash sugli ID)
+        row = transactions.append(*t);
+        lsn = commitRow(row);
+        j = journal;
+    }
+    waitJournal(j, lsn, row, t->getId());
+}
+
+void BankAccount::addTransaction(const TransactionRecord& r, const BankAccount* destinationAccount) {
+    std::shared_ptr<TransactionJournal> j;
+    std::uint64_t lsn = 0;
+    std::size_t row;
+    {
+        WriteLock lock(*this);
+        // Codici calcolati una volta: servono alla regola sui trasferimenti e allo store
+        const auto codes = TransactionStore::intern(r);
+        checkRules(totals.balance, r.kind, r.value(), codes.category == StringDictionary::kTransfer,
+                   destinationAccount);
+        row = transactions.append(r, codes);
+        lsn = commitRow(row);
+        j = journal;
+    }
+    waitJournal(j, lsn, row, j ? std::string(r.id) : std::string());
+}
+
+void BankAccount::addTransactions(std::span<const TransactionRecord> batch,
+                                  const BankAccount* destinationAccount) {
+    WriteLock lock(*this);
+    // 1) Validazione completa prima di toccare lo store
+    Money running = totals.balance;
+    std::unordered_set<std::string_view> batchIds;
+    batchIds.reserve(batch.size());
+    std::vector<TransactionStore::FieldCodes> codes;
+    codes.reserve(batch.size());
+    for (const auto& r : batch) {
+        codes.push_back(TransactionStore::intern(r));
+        checkRules(running, r.kind, r.value(), codes.back().category == StringDictionary::kTransfer,
+                   destinationAccount);
+        if (transactions.containsId(r.id) || !batchIds.insert(r.id).second) {
+            throw std::runtime_error("Duplicate transaction ID: " + std::string(r.id));
+        }
+        running += r.value();
+    }
+
+    // 2) Inserimento e journal
+    appendValidated(batch, codes, lock);
+}
+
+void BankAccount::importRecords(std::span<const TransactionRecord> batch, const std::string& pwd) {
+    requireAuth(pwd);
+    WriteLock lock(*this);
+    appendValidated(batch, {}, lock);
+}
+
+void BankAccount::appendValidated(std::span<const TransactionRecord> batch,
+                                  std::span<const TransactionStore::FieldCodes> codes, WriteLock& lock) {
+    // Inserimento atomico (lo store annulla il blocco se qualcosa fallisce)
+    const std::size_t firstRow = transactions.size();
+    transactions.appendBatch(batch, codes);
+
+    // Journal prima dei totali: tutte le righe in coda, una sola attesa (e di solito
+    // una sola fdatasync); se un record viene rifiutato il blocco sparisce dallo store
+    std::uint64_t last = 0;
+    if (journal) {
+        try {
+            for (std::size_t row = firstRow; row < transactions.size(); ++row) {
+                last = journal->append(transactions[row].record());
+            }
+        } catch (...) {
+            transactions.truncate(firstRow);
+            throw;
+        }
+    }
+
+    const auto added = aggregate::summarize(transactions.amounts().subspan(firstRow),
+                                            transactions.kinds().subspan(firstRow));
+    totals.deposits += added.deposits;
+    totals.withdrawals += added.withdrawals;
+    totals.balance += added.balance;
+    for (std::size_t row = firstRow; row < transactions.size(); ++row) {
+        rollupIndex.add(transactions[row]);
+        balanceIndex.add(transactions[row]);
+    }
+
+    const auto j = journal;
+    const std::string firstId = j && !batch.empty() ? std::string(batch.front().id) : std::string();
+    lock.unlock();
+    waitJournal(j, last, firstRow, firstId);
+}
+
+void BankAccount::addTransactions(std::span<const std::unique_ptr<Transaction>> batch,
+                                  const BankAccount* destinationAccount) {
+    // Le viste puntano negli oggetti del chiamante, vivi per tutta la chiamata
+    std::vector<TransactionRecord> records;
+    records.reserve(batch.size());
+    for (const auto& t : batch) {
+        records.push_back(TransactionRecord{t->getId(), t->getData(), t->getAmount(), t->kind(),
+                                            t->getDescription(), t->getCategory(), t->getOperationType(),
+                                            t->getSenderAccount(), t->getReceiverAccount()});
     }
-    return total;
+    addTransactions(records, destinationAccount);
+}
+
+Money BankAccount::balance() const {
+    ReadLock lock(*this);
+    return totals.balance;
 }
 
 void BankAccount::requireAuth(const std::string& pwd) const {
@@ -131,193 +330,278 @@ void BankAccount::requireAuth(const std::string& pwd) const {
     }
 }
 
-const Transaction* BankAccount::findTransactionById(const std::string& txId) const {
-    for (const auto& t : transactions) {
-        if (t->getId() == txId) {
-            return t.get();
-        }
+std::optional<TransactionRow> BankAccount::findTransactionById(const std::string& txId) const {
+    ReadLock lock(*this);
+    if (const auto row = transactions.findId(txId)) {
+        return TransactionRow(transactions, *row);
     }
-    return nullptr;
+    return std::nullopt;
+}
+
+std::vector<TransactionRow> BankAccount::filterByType(const std::string& opType) const {
+    ReadLock lock(*this);
+    return selectByType(opType);
 }
 
-std::vector<const Transaction*> BankAccount::filterByType(const std::string& opType) const {
-    std::vector<const Transaction*> out;
-    for (const auto& t : transactions) {
-        if (t->getOperationType() == opType) {
-            out.push_back(t.get());
+std::vector<TransactionRow> BankAccount::selectByType(std::string_view opType) const {
+    std::vector<TransactionRow> out;
+    if (transactions.hasSecondaryIndexes()) {
+        const auto rows = transactions.rowsWithOperationType(opType);
+        out.reserve(rows.size());
+        for (const auto row : rows) out.emplace_back(transactions, row);
+        return out;
+    }
+    // Senza indici: confronto fra codici, la stringa si cerca una volta sola
+    const auto code = StringDictionary::shared().find(opType);
+    if (!code) return out;
+    const auto types = transactions.operationTypeCodes();
+    for (std::size_t row = 0; row < types.size(); ++row) {
+        if (types[row] == *code) {
+            out.emplace_back(transactions, row);
         }
     }
     return out;
 }
 
-std::vector<const Transaction*> BankAccount::filterByCounterparty(const std::string& accountId) const {
-    std::vector<const Transaction*> out;
-    for (const auto& t : transactions) {
-        if (t->getSenderAccount() == accountId ||
-            t->getReceiverAccount() == accountId) {
-            out.push_back(t.get());
+std::vector<TransactionRow> BankAccount::filterByCounterparty(const std::string& accountId) const {
+    ReadLock lock(*this);
+    return selectByCounterparty(accountId);
+}
+
+std::vector<TransactionRow> BankAccount::selectByCounterparty(std::string_view accountId) const {
+    std::vector<TransactionRow> out;
+    if (transactions.hasSecondaryIndexes()) {
+        const auto rows = transactions.rowsWithCounterparty(accountId);
+        out.reserve(rows.size());
+        for (const auto row : rows) out.emplace_back(transactions, row);
+        return out;
+    }
+    const auto code = StringDictionary::shared().find(accountId);
+    if (!code) return out;
+    const auto senders = transactions.senderCodes();
+    const auto receivers = transactions.receiverCodes();
+    for (std::size_t row = 0; row < senders.size(); ++row) {
+        if (senders[row] == *code || receivers[row] == *code) {
+            out.emplace_back(transactions, row);
         }
     }
     return out;
 }
 
+std::vector<TransactionRow> BankAccount::select(const TransactionQuery& q) const {
+    ReadLock lock(*this);
+    const auto views = q.collect(transactions);
+    std::vector<TransactionRow> out;
+    out.reserve(views.size());
+    for (const auto& t : views) {
+        out.emplace_back(transactions, t.row());
+    }
+    return out;
+}
+
+QueryExplain BankAccount::explain(const TransactionQuery& q) const {
+    ReadLock lock(*this);
+    return q.explain(transactions);
+}
+
+std::size_t BankAccount::render(const std::string& pwd, const TransactionQuery& q, ReportSink& sink,
+                                ReportRenderer::Options options) const {
+    requireAuth(pwd);
+    ReportRenderer out(sink, options);
+    std::vector<std::uint32_t> rows;
+    std::uint64_t seen;
+    {
+        ReadLock lock(*this);
+        q.forEach(transactions, [&](const TransactionView& t) { rows.push_back(static_cast<std::uint32_t>(t.row())); });
+        seen = generation;
+    }
+    renderRows(out, rows, seen);
+    if (out.rowCount() == 0) out.noResults();
+    out.flush();
+    return out.rowCount();
+}
+
+void BankAccount::renderTransactions(ReportSink& sink, ReportRenderer::Options options) const {
+    ReportRenderer out(sink, options);
+    std::vector<std::uint32_t> rows;
+    Summary sum;
+    std::uint64_t seen;
+    {
+        ReadLock lock(*this);
+        const auto order = transactions.rowsByTime();
+        rows.assign(order.begin(), order.end());
+        sum = totals;
+        seen = generation;
+    }
+    out.header();
+    renderRows(out, rows, seen);
+    out.summary(sum.deposits, sum.withdrawals, sum.balance);
+    out.flush();
+}
+
+void BankAccount::renderRows(ReportRenderer& out, std::span<const std::uint32_t> rows, std::uint64_t seen) const {
+    // Un buffer pieno per volta sotto il lock; il sink (fd, stream lenti) scrive senza lock
+    std::size_t next = 0;
+    while (next < rows.size()) {
+        {
+            ReadLock lock(*this);
+            if (generation != seen) {
+                throw std::runtime_error("Account reloaded while rendering");
+            }
+            do {
+                out.stage(transactions[rows[next++]]);
+            } while (next < rows.size() && !out.full());
+        }
+        if (out.full()) out.flush();
+    }
+}
+
+void BankAccount::printFiltered(const std::string& pwd, const TransactionQuery& q) const {
+    StreamSink sink(std::cout);
+    render(pwd, q, sink);
+}
+
 void BankAccount::printTransactionById(const std::string& pwd,
                                        const std::string& txId) const {
-    printFiltered(pwd, [&](const Transaction& t) {
-        return t.getId() == txId;
-    });
+    StreamSink sink(std::cout);
+    render(pwd, TransactionQuery().id(txId), sink);
 }
 
 void BankAccount::printTransactionsByType(const std::string& pwd,
                                           const std::string& opType) const {
-    printFiltered(pwd, [&](const Transaction& t) {
-        return t.getOperationType() == opType;
-    });
+    StreamSink sink(std::cout);
+    // Il pianificatore usa la posting list del tipo (o la scansione, se più corta) e ordina i risultati per tempo
+    render(pwd, TransactionQuery().type(opType), sink);
 }
 
 void BankAccount::printTransactionsByAccount(const std::string& pwd,
                                              const std::string& accountId) const {
-    printFiltered(pwd, [&](const Transaction& t) {
-        return t.getSenderAccount() == accountId || t.getReceiverAccount() == accountId;
-    });
+    StreamSink sink(std::cout);
+    render(pwd, TransactionQuery().counterparty(accountId), sink);
 }
 
 void BankAccount::printTransactions() const {
-    std::cout << "\n--- Transaction List ---\n";
+    StreamSink sink(std::cout);
+    renderTransactions(sink);
+}
 
-    auto sorted = getSortedTransactions();
-    Summary summary = computeSummary();
+void BankAccount::SaveToFile(const std::string& filename, const std::string& pwd, bool sync) const {
+    requireAuth(pwd);
+    CsvWriter file(filename, CsvWriter::Options{.sync = sync});
+    ReadLock lock(*this);
 
-    for (const auto* t : sorted) {
-        printTransaction(*t);
+    file.writePreamble(ownerId, bankId);
+    for (const auto row : transactions.rowsByTime()) {
+        file.writeRow(transactions[row]);
     }
-
-    std::cout << "----------------------------------------------\n";
-    std::cout << std::format(
-        "Total Deposits: \x1b[38;2;0;100;0m{:.2f}\x1b[0m\n Total Withdrawals: \x1b[38;2;139;0;0m{:.2f}\x1b[0m\nBalance: {:.2f}\n",
-        summary.deposits, summary.withdrawals, summary.balance
-    );
+    file.writeSummary(totals.deposits, totals.withdrawals, totals.balance);
+    file.close();
 }
 
-void BankAccount::SaveToFile(const std::string& filename, const std::string& pwd) const {
+void BankAccount::ReadFromFile(const std::string& filename, const std::string& pwd, unsigned threads) {
     requireAuth(pwd);
-    std::ofstream file(filename);
-    if (!file) throw std::runtime_error("Error opening file");
-
-    // BOM UTF-8 per Excel
-    file << "\xEF\xBB\xBF";
-
-    file << std::format("Account Owner: {}, Bank: {}\n", ownerId, bankId);
-    file << "\"ID\";\"Date\";\"Amount\";\"Operation\";\"Category\";\"Description\";\"Sender\";\"Receiver\"\r\n";
 
-    auto sorted = getSortedTransactions();
-    Summary summary = computeSummary();
+    // File mappato in memoria: le celle sono string_view, copiate solo nelle colonne
+    const MappedFile file(filename);
+    CsvReader reader(file.view());
 
-    for (const auto* t : sorted) {
-        std::string amt = std::format("{:.2f}", t->getAmount());
-        std::replace(amt.begin(), amt.end(), '.', ',');
-
-        file << std::format("\"{}\";\"{}\";\"{}\";\"{}\";\"{}\";\"{}\";\"{}\";\"{}\"\r\n",
-                            t->getId(),
-                            t->getDataFormatted().substr(0,19),
-                            amt,
-                            t->getOperationType(),
-                            t->getCategory(),
-                            t->getDescription(),
-                            t->getSenderAccount(),
-                            t->getReceiverAccount());
+    // 1) Prima riga: "Account Owner: X, Bank: Y" -> validazione coerenza
+    const auto preamble = reader.readPreamble();
+    if (preamble.owner != ownerId || preamble.bank != bankId) {
+        throw std::runtime_error("File does not match this account (owner/bank mismatch)");
     }
 
-    std::string deposits = std::format("{:.2f}", summary.deposits);
-    std::replace(deposits.begin(), deposits.end(), '.', ',');
-    std::string withdrawals = std::format("{:.2f}", summary.withdrawals);
-    std::replace(withdrawals.begin(), withdrawals.end(), '.', ',');
-    std::string balanceStr = std::format("{:.2f}", summary.balance);
-    std::replace(balanceStr.begin(), balanceStr.end(), '.', ',');
-
-    file << std::format("Summary; Total Deposits: {};Total Withdrawals: {};Final Balance: {}\r\n",
-                        deposits, withdrawals, balanceStr);
+    WriteLock lock(*this);
+    transactions.clear();
+    ++generation;
+    resetTotals();
+
+    // 2) Righe dati, fino al sommario: parsing e interning nei worker, qui solo un
+    //    appendBatch per blocco; totali calcolati alla fine sulle colonne, anche se una
+    //    riga è invalida
+    try {
+        reader.readAllInterned([&](std::span<const TransactionRecord> batch,
+                                   std::span<const TransactionStore::FieldCodes> codes) {
+            try {
+                transactions.appendBatch(batch, codes);
+            } catch (const std::runtime_error&) {
+                // Blocco rifiutato (ID duplicato): riga per riga restano le righe precedenti
+                // e risale lo stesso errore
+                for (std::size_t i = 0; i < batch.size(); ++i) {
+                    transactions.append(batch[i], codes[i]);
+                }
+            }
+        }, threads);
+    } catch (...) {
+        recomputeTotals();
+        throw;
+    }
+    recomputeTotals();
 }
 
-void BankAccount::ReadFromFile(const std::string& filename, const std::string& pwd) {
+void BankAccount::SaveSnapshot(const std::string& filename, const std::string& pwd) const {
     requireAuth(pwd);
-    transactions.clear();
-
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) throw std::runtime_error("Error opening file");
-
-    std::string line;
-
-    // 1) Prima riga: "Account Owner: X, Bank: Y" -> validazione coerenza
-    if (!std::getline(file, line)) throw std::runtime_error("Empty file");
-    {
-        const std::string ownerKey = "Account Owner: ";
-        const std::string bankKey  = ", Bank: ";
+    ReadLock lock(*this);
+    snapshot::write(filename, ownerId, bankId, transactions);
+}
 
-        const auto pOwner = line.find(ownerKey);
-        const auto pBank  = line.find(bankKey);
-        if (pOwner == std::string::npos || pBank == std::string::npos || pBank <= pOwner + ownerKey.size()) {
-            throw std::runtime_error("Malformed header line: " + line);
-        }
-        const std::string fileOwner = line.substr(pOwner + ownerKey.size(), pBank - (pOwner + ownerKey.size()));
-        const std::string fileBank  = line.substr(pBank + bankKey.size());
+void BankAccount::LoadSnapshot(const std::string& filename, const std::string& pwd) {
+    requireAuth(pwd);
+    WriteLock lock(*this);
+    loadSnapshot(filename);
+}
 
-        if (fileOwner != ownerId || fileBank != bankId) {
-            throw std::runtime_error("File does not match this account (owner/bank mismatch)");
-        }
+void BankAccount::loadSnapshot(const std::string& filename) {
+    const snapshot::Reader reader(filename);
+    if (reader.owner() != ownerId || reader.bank() != bankId) {
+        throw std::runtime_error("File does not match this account (owner/bank mismatch)");
     }
 
-    // 2) Header CSV (atteso con Sender,Receiver)
-    if (!std::getline(file, line)) throw std::runtime_error("Missing CSV header");
+    // Nessun parsing: i record puntano direttamente nel file mappato, i codici sono
+    // calcolati una volta per stringa distinta
+    std::vector<TransactionRecord> records;
+    std::vector<TransactionStore::FieldCodes> codes;
+    reader.readAll(records, codes);
 
-    // 3) Righe dati
-    while (std::getline(file, line)) {
-        if (line.rfind("Summary", 0) == 0) {
-            break; // ignora il sommario
-        }
+    transactions.clear();
+    ++generation;
+    resetTotals();
+    try {
+        transactions.appendBatch(records, codes);
+    } catch (...) {
+        recomputeTotals();
+        throw;
+    }
+    recomputeTotals();
+}
 
-        std::array<std::string, 8> cols{};
-        std::stringstream ss(line);
-        std::string cell;
-        int i = 0;
-        while (std::getline(ss, cell, ';')) {
-            // Rimuove eventuali doppi apici
-            if (!cell.empty() && cell.front() == '"' && cell.back() == '"') {
-                cell = cell.substr(1, cell.size()-2);
-            }
-            // Converte decimali italiani (',' -> '.')
-            std::replace(cell.begin(), cell.end(), ',', '.');
+void BankAccount::Recover(const std::string& snapshotFile, const std::string& journalFile,
+                          const std::string& pwd) {
+    requireAuth(pwd);
+    WriteLock lock(*this);
+    if (std::filesystem::exists(snapshotFile)) {
+        loadSnapshot(snapshotFile);
+    } else {
+        transactions.clear();
+        ++generation;
+        resetTotals();
+    }
 
-            if (i < 8) cols[i++] = cell;
-        }
-        if (i != 8) throw std::runtime_error("Malformed CSV line: " + line);
-
-        const std::string& id        = cols[0];
-        const std::string& dateS     = cols[1];
-        const std::string& amtS      = cols[2];
-        const std::string& op        = cols[3];
-        const std::string& cat       = cols[4];
-        const std::string& desc      = cols[5];
-        const std::string& senderAcc = cols[6];
-        const std::string& recvAcc   = cols[7];
-
-        double amount = 0.0;
-        try {
-            amount = std::stod(amtS);
-        } catch (...) {
-            throw std::runtime_error("Invalid amount: " + amtS);
+    // Le transazioni già nello snapshot (checkpoint interrotto prima del reset) si saltano
+    auto recovered = std::make_shared<TransactionJournal>(journalFile);
+    recovered->replay([&](const TransactionRecord& r) {
+        if (!transactions.containsId(r.id)) {
+            accumulate(transactions[transactions.append(r)]);
         }
+    });
+    journal = std::move(recovered);
+}
 
-        TimePoint tp = parseDateTime(dateS);
-
-        if (op == "Income") {
-            auto tx = std::make_unique<Income>(id, tp, amount, desc, cat, op, senderAcc, recvAcc);
-            transactions.push_back(std::move(tx));
-        } else if (op == "Expense") {
-            auto tx = std::make_unique<Expense>(id, tp, amount, desc, cat, op, senderAcc, recvAcc);
-            transactions.push_back(std::move(tx));
-        } else {
-            throw std::runtime_error("Unknown Operation in CSV: " + op);
-        }
-    }
-}
\ No newline at end of file
+void BankAccount::Checkpoint(const std::string& snapshotFile, const std::string& pwd) {
+    requireAuth(pwd);
+    // In esclusiva: nessun inserimento fra lo snapshot e lo svuotamento del journal
+    WriteLock lock(*this);
+    // write() ritorna con file e rename già su disco: solo allora il journal si può svuotare
+    snapshot::write(snapshotFile, ownerId, bankId, transactions, true);
+    if (journal) journal->reset();
+}
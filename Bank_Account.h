@@ -8,19 +8,44 @@
 
 
 #include <vector>
+#include <atomic>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <utility>
+#include "Aggregate_Kernels.h"
+#include "Balance_Index.h"
+#include "Report_Renderer.h"
+#include "Rollup_Index.h"
 #include "Transaction.h"
+#include "Transaction_Query.h"
+#include "Transaction_Store.h"
 
+class TransactionJournal;
+
+// SharedReaders: le letture prendono il lock in modo condiviso e procedono in parallelo
+// fra loro; Exclusive: ogni operazione prende il lock in esclusiva (un solo mutex).
+enum class ConcurrencyMode { SharedReaders, Exclusive };
+
+// Thread-safe: scritture (inserimenti, caricamenti) in esclusiva, letture condivise.
+// I metodi che restituiscono righe le copiano (TransactionRow) sotto il lock: restano
+// valide dopo il rilascio. Le TransactionView puntano nello store e si usano solo
+// dentro read() e query().
 class BankAccount {
 private:
     std::string ownerId;
     std::string bankId;
     std::string password;
-    std::vector<std::unique_ptr<Transaction>> transactions;
+    TransactionStore transactions;
 
 public:
-    BankAccount(std::string owner, std::string bank, std::string pwd)
-        : ownerId(owner), bankId(bank), password(pwd) {}
+    // mr: risorsa da cui allocano le colonne dello store (deve sopravvivere al conto)
+    BankAccount(std::string owner, std::string bank, std::string pwd,
+                std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : ownerId(owner), bankId(bank), password(pwd), transactions(mr), rollupIndex(mr), balanceIndex(mr) {}
 
     const std::string getOwnerId() const{
         return ownerId;
@@ -35,32 +60,228 @@ public:
 
     void requireAuth(const std::string& pwd) const;
 
+    // Da impostare prima di condividere il conto fra thread
+    void setConcurrencyMode(ConcurrencyMode m) {
+        mode = m;
+    }
+    ConcurrencyMode concurrencyMode() const {
+        return mode;
+    }
+    // Esegue f(store) con il lock di lettura: le viste usate dentro f sono stabili.
+    // f non deve chiamare metodi del conto (il lock non è rientrante).
+    template <class F>
+    decltype(auto) read(F&& f) const {
+        ReadLock lock(*this);
+        return std::forward<F>(f)(transactions);
+    }
+
     void addTransaction(std::unique_ptr<Transaction> t, const BankAccount* destinationAcc = nullptr);
-    double balance() const;
-    const Transaction* findTransactionById(const std::string& txId) const;
-    std::vector<const Transaction*> filterByType(const std::string& opType) const;
-    std::vector<const Transaction*> filterByCounterparty(const std::string& accountId) const;
+    // Stesse regole senza passare da un oggetto Transaction (nessuna allocazione per riga)
+    void addTransaction(const TransactionRecord& r, const BankAccount* destinationAcc = nullptr);
+    // Blocco tutto o niente: le righe sono validate in ordine contro il saldo progressivo
+    // (uno scoperto a metà blocco viene rilevato), poi inserite con un solo reserve e
+    // un solo merge dell'ordine temporale. destinationAcc vale per tutti i Transfer del blocco.
+    void addTransactions(std::span<const TransactionRecord> batch, const BankAccount* destinationAcc = nullptr);
+    void addTransactions(std::span<const std::unique_ptr<Transaction>> batch,
+                         const BankAccount* destinationAcc = nullptr);
+    // Caricamento fidato in blocco, come ReadFromFile ma da memoria (es. dati generati):
+    // nessuna regola su saldo o trasferimenti, solo ID unici; tutto o niente
+    void importRecords(std::span<const TransactionRecord> batch, const std::string& pwd);
+    Money balance() const;
+    std::optional<TransactionRow> findTransactionById(const std::string& txId) const;
+    std::vector<TransactionRow> filterByType(const std::string& opType) const;
+    std::vector<TransactionRow> filterByCounterparty(const std::string& accountId) const;
+    // Interrogazione in streaming sotto il lock di lettura: f(TransactionView) per ogni
+    // risultato, senza vettori intermedi; restituisce quanti risultati sono usciti.
+    // f non deve chiamare metodi del conto.
+    template <class F>
+    std::size_t query(const TransactionQuery& q, F&& f) const {
+        ReadLock lock(*this);
+        return q.forEach(transactions, std::forward<F>(f));
+    }
+    std::vector<TransactionRow> select(const TransactionQuery& q) const;
+    // Percorso scelto dal pianificatore e righe esaminate (la query viene eseguita)
+    QueryExplain explain(const TransactionQuery& q) const;
+
+    // Risultato della query in streaming verso sink (ostream, fd o stringa) attraverso
+    // il buffer del renderer; "No transactions found" se vuoto (solo Pretty).
+    // Restituisce le righe scritte. Il lock di lettura copre la query e la formattazione
+    // di un buffer per volta, mai le scritture sul sink; se nel frattempo il conto viene
+    // ricaricato o perde righe (journal fallito) lancia std::runtime_error.
+    std::size_t render(const std::string& pwd, const TransactionQuery& q, ReportSink& sink,
+                       ReportRenderer::Options options = {}) const;
+    // Estratto completo in ordine temporale con i totali (il formato di printTransactions)
+    void renderTransactions(ReportSink& sink, ReportRenderer::Options options = {}) const;
 
     void printTransactionById(const std::string& pwd, const std::string& txId) const;
     void printTransactionsByType(const std::string& pwd, const std::string& opType) const;
     void printTransactionsByAccount(const std::string& pwd, const std::string& accountId) const;
     void printTransactions() const;
 
+    // Predicato opaco: scansione completa in ordine temporale
     template <class Pred>
     void printFiltered(const std::string& pwd, Pred predicate) const;
+    // Condizioni strutturate: il pianificatore usa l'indice più selettivo
+    void printFiltered(const std::string& pwd, const TransactionQuery& q) const;
     void validateTransfer(const BankAccount* destinationAccount) const;
 
-    void SaveToFile(const std::string& filename, const std::string& pwd) const;
-    void ReadFromFile(const std::string& filename, const std::string& pwd);
+    // sync: fsync prima di chiudere il file
+    void SaveToFile(const std::string& filename, const std::string& pwd, bool sync = false) const;
+    // threads > 1: parsing e interning a blocchi in parallelo (0 = tutti i core), stesso
+    // risultato; nello store entra un blocco intero per volta (indici per ID e per
+    // controparte restano sequenziali)
+    void ReadFromFile(const std::string& filename, const std::string& pwd, unsigned threads = 1);
+
+    // Snapshot binario (vedi Snapshot.h): caricamento via mmap, senza parsing per riga
+    void SaveSnapshot(const std::string& filename, const std::string& pwd) const;
+    void LoadSnapshot(const std::string& filename, const std::string& pwd);
+
+    // Journal opzionale: ogni addTransaction riuscita vi aggiunge un record e ritorna
+    // solo quando il record è su disco (fdatasync condivise fra scritture concorrenti)
+    void attachJournal(std::shared_ptr<TransactionJournal> j) {
+        WriteLock lock(*this);
+        journal = std::move(j);
+    }
+    // Avvio: ultimo snapshot (se esiste) + replay del journal, poi il journal resta attaccato
+    void Recover(const std::string& snapshotFile, const std::string& journalFile, const std::string& pwd);
+    // Snapshot completo e svuotamento del journal
+    void Checkpoint(const std::string& snapshotFile, const std::string& pwd);
 
     struct Summary {
-        double deposits{};
-        double withdrawals{};
-        double balance{};
+        Money deposits{};
+        Money withdrawals{};
+        Money balance{};
     };
     Summary computeSummary() const;
+    // Saldo storico: transazioni con data <= t; totali delle transazioni in [from, to).
+    // Entrambi in O(log n) sull'indice a somme prefisso (vedi BalanceIndex)
+    Money balanceAt(TimePoint t) const;
+    Summary summaryBetween(TimePoint from, TimePoint to) const;
+
+    // Ricalcolo completo in una passata sulle colonne (kernel SIMD), con conteggi,
+    // minimo/massimo dei valori e somma per categoria (in ordine di nome)
+    struct Statistics {
+        aggregate::Totals totals;
+        std::vector<std::pair<std::string, Money>> byCategory;
+    };
+    Statistics computeStatistics() const;
+
+    // Aggregati per giorno/mese x categoria x tipo, mantenuti a ogni inserimento:
+    // costo proporzionale ai bucket, non alle righe (vedi RollupIndex)
+    std::vector<Rollup> rollups(RollupPeriod period, TimePoint from, TimePoint to) const;
+    std::vector<CategoryRollup> categoryTotals(TimePoint from, TimePoint to) const;
+
+    std::vector<TransactionRow> getSortedTransactions() const;
+    // Transazioni con data in [from, to), in ordine temporale
+    std::vector<TransactionRow> between(TimePoint from, TimePoint to) const;
+
+    // Numero di righe sotto il lock di lettura; per tutto il resto dello store, read()
+    std::size_t transactionCount() const {
+        ReadLock lock(*this);
+        return transactions.size();
+    }
+    // Indici per tipo e controparte (attivi di default)
+    void setSecondaryIndexes(bool enabled) {
+        WriteLock lock(*this);
+        transactions.setSecondaryIndexes(enabled);
+    }
+
+private:
+    // Ledger blocca due conti insieme per i trasferimenti
+    friend class Ledger;
+
+    // Totali aggiornati a ogni inserimento: balance() e computeSummary() in O(1)
+    Summary totals;
+    RollupIndex rollupIndex;
+    BalanceIndex balanceIndex;
+    std::shared_ptr<TransactionJournal> journal;
+    mutable std::shared_mutex mutex;
+    // shared_mutex (pthread_rwlock) favorisce i lettori: con letture continue un inserimento
+    // non passerebbe mai. Gli scrittori si contano qui dall'attesa fino al rilascio e i nuovi
+    // lettori aspettano che il conteggio torni a zero; writerGate serializza solo gli scrittori,
+    // i lettori non lo toccano.
+    mutable std::atomic<std::uint32_t> waitingWriters{0};
+    mutable std::mutex writerGate;
+    ConcurrencyMode mode = ConcurrencyMode::SharedReaders;
+
+    class ReadLock {
+    private:
+        const BankAccount& account;
+    public:
+        explicit ReadLock(const BankAccount& a) : account(a) {
+            if (account.mode == ConcurrencyMode::Exclusive) {
+                account.mutex.lock();
+                return;
+            }
+            for (;;) {
+                const auto writers = account.waitingWriters.load(std::memory_order_acquire);
+                if (writers == 0) break;
+                account.waitingWriters.wait(writers, std::memory_order_acquire);
+            }
+            account.mutex.lock_shared();
+        }
+        ~ReadLock() {
+            if (account.mode == ConcurrencyMode::Exclusive) account.mutex.unlock();
+            else                                              account.mutex.unlock_shared();
+        }
+        ReadLock(const ReadLock&) = delete;
+        ReadLock& operator=(const ReadLock&) = delete;
+    };
+
+    class WriteLock {
+    private:
+        const BankAccount& account;
+        bool owned = true;
+    public:
+        explicit WriteLock(const BankAccount& a) : account(a) {
+            account.waitingWriters.fetch_add(1, std::memory_order_acq_rel);
+            account.writerGate.lock();
+            account.mutex.lock();
+        }
+        ~WriteLock() {
+            unlock();
+        }
+        void unlock() {
+            if (!owned) return;
+            owned = false;
+            account.mutex.unlock();
+            account.writerGate.unlock();
+            if (account.waitingWriters.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                account.waitingWriters.notify_all();
+            }
+        }
+        WriteLock(const WriteLock&) = delete;
+        WriteLock& operator=(const WriteLock&) = delete;
+    };
+
+    // Cambia quando righe già visibili ai lettori spariscono (ricarica, journal fallito)
+    std::uint64_t generation = 0;
+    // Formatta rows a blocchi sotto il lock e li scrive dopo averlo rilasciato;
+    // seen: generation letta insieme a rows
+    void renderRows(ReportRenderer& out, std::span<const std::uint32_t> rows, std::uint64_t seen) const;
+
+    // Versioni senza lock, per chi lo tiene già
+    std::vector<TransactionRow> selectByType(std::string_view opType) const;
+    std::vector<TransactionRow> selectByCounterparty(std::string_view accountId) const;
+    void loadSnapshot(const std::string& filename);
+    // Blocco già validato: store, totali, indici e journal (rilascia il lock prima dell'attesa).
+    // codes: TransactionStore::intern() di ogni record, se già calcolati (vuoto: li calcola lo store)
+    void appendValidated(std::span<const TransactionRecord> batch,
+                         std::span<const TransactionStore::FieldCodes> codes, WriteLock& lock);
 
-    std::vector<const Transaction*> getSortedTransactions() const;
+    void accumulate(const TransactionView& t);
+    void checkRules(Money currentBalance, TransactionKind kind, Money value, bool transfer,
+                    const BankAccount* destinationAccount) const;
+    // Restituisce il numero di sequenza del journal da attendere (0 = nessuno)
+    std::uint64_t commitRow(std::size_t row);
+    // Attesa della durabilità senza lock; se fallisce la riga row (con ID id) e le
+    // successive vengono tolte dal conto prima di rilanciare
+    void waitJournal(const std::shared_ptr<TransactionJournal>& j, std::uint64_t lsn,
+                     std::size_t row, const std::string& id);
+    void discardFrom(std::size_t row, const std::string& id);
+    void resetTotals();
+    // Totali e rollup ricalcolati dalle colonne dopo un caricamento in blocco
+    void recomputeTotals();
 };
 
 
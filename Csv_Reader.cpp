@@ -0,0 +1,346 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "Csv_Reader.h"
+
+// Primo byte uguale a c in [p, end), oppure end. SSE2: 16 byte per confronto.
+static const char* findByte(const char* p, const char* end, char c) {
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask != 0) return p + std::countr_zero(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != c) ++p;
+    return p;
+}
+
+static std::string_view nextLine(std::string_view text, std::size_t& pos) {
+    const char* begin = text.data() + pos;
+    const char* end = text.data() + text.size();
+    const char* nl = findByte(begin, end, '\n');
+    pos = nl == end ? text.size() : static_cast<std::size_t>(nl - text.data()) + 1;
+    std::string_view line(begin, static_cast<std::size_t>(nl - begin));
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+static int parseDigits(const char* p, int n, bool& ok) {
+    int value = 0;
+    for (int i = 0; i < n; ++i) {
+        const unsigned d = static_cast<unsigned char>(p[i]) - '0';
+        if (d > 9) ok = false;
+        value = value * 10 + static_cast<int>(d);
+    }
+    return value;
+}
+
+TimePoint CsvReader::parseDateTime(std::string_view s) {
+    // Formato fisso "YYYY-MM-DD HH:MM:SS", come scritto da SaveToFile (UTC)
+    bool ok = s.size() == 19 && s[4] == '-' && s[7] == '-' && s[10] == ' ' && s[13] == ':' && s[16] == ':';
+    if (ok) {
+        const char* p = s.data();
+        const int y  = parseDigits(p, 4, ok);
+        const int mo = parseDigits(p + 5, 2, ok);
+        const int d  = parseDigits(p + 8, 2, ok);
+        const int h  = parseDigits(p + 11, 2, ok);
+        const int mi = parseDigits(p + 14, 2, ok);
+        const int se = parseDigits(p + 17, 2, ok);
+        const std::chrono::year_month_day ymd{std::chrono::year{y},
+                                              std::chrono::month{static_cast<unsigned>(mo)},
+                                              std::chrono::day{static_cast<unsigned>(d)}};
+        if (ok && ymd.ok() && h < 24 && mi < 60 && se < 61) {
+            return std::chrono::sys_days{ymd} + std::chrono::hours{h} +
+                   std::chrono::minutes{mi} + std::chrono::seconds{se};
+        }
+    }
+    throw std::runtime_error("Invalid datetime format: " + std::string(s));
+}
+
+Money CsvReader::parseAmount(std::string_view s) {
+    // Decimali con ',' (o '.'), direttamente in centesimi
+    return Money::parse(s);
+}
+
+void CsvReader::parseLine(std::string_view line, TransactionRecord& out) {
+    std::array<std::string_view, 8> cols{};
+    std::size_t n = 0;
+    const char* p = line.data();
+    const char* end = p + line.size();
+    const auto malformed = [&] {
+        return std::runtime_error("Malformed CSV line: " + std::string(line));
+    };
+
+    for (;;) {
+        const char* cellEnd = nullptr;
+        std::string_view cell;
+        if (p < end && *p == '"') {
+            // Cella quotata: si chiude con '"' seguito da ';' o da fine riga
+            const char* q = p + 1;
+            for (;;) {
+                q = findByte(q, end, '"');
+                if (q == end || q + 1 == end || q[1] == ';') break;
+                ++q;
+            }
+            if (q != end) {
+                cell = std::string_view(p + 1, static_cast<std::size_t>(q - p - 1));
+                cellEnd = q + 1;
+            }
+        }
+        if (!cellEnd) {
+            cellEnd = findByte(p, end, ';');
+            cell = std::string_view(p, static_cast<std::size_t>(cellEnd - p));
+        }
+        if (n == cols.size()) throw malformed();
+        cols[n++] = cell;
+        if (cellEnd == end) break;
+        p = cellEnd + 1;
+    }
+    if (n != cols.size()) throw malformed();
+
+    out.id = cols[0];
+    out.amount = parseAmount(cols[2]);
+    out.data = parseDateTime(cols[1]);
+    out.operationType = cols[3];
+    out.category = cols[4];
+    out.description = cols[5];
+    out.senderAccount = cols[6];
+    out.receiverAccount = cols[7];
+
+    if (out.operationType == "Income") {
+        out.kind = TransactionKind::Income;
+    } else if (out.operationType == "Expense") {
+        out.kind = TransactionKind::Expense;
+    } else {
+        throw std::runtime_error("Unknown Operation in CSV: " + std::string(out.operationType));
+    }
+}
+
+CsvReader::Preamble CsvReader::readPreamble() {
+    if (text.empty()) throw std::runtime_error("Empty file");
+
+    // 1) "Account Owner: X, Bank: Y" (eventualmente preceduta dal BOM)
+    const std::string_view line = nextLine(text, pos);
+    constexpr std::string_view ownerKey = "Account Owner: ";
+    constexpr std::string_view bankKey  = ", Bank: ";
+    const auto pOwner = line.find(ownerKey);
+    const auto pBank  = line.find(bankKey);
+    if (pOwner == std::string_view::npos || pBank == std::string_view::npos ||
+        pBank <= pOwner + ownerKey.size()) {
+        throw std::runtime_error("Malformed header line: " + std::string(line));
+    }
+    Preamble preamble{
+        line.substr(pOwner + ownerKey.size(), pBank - (pOwner + ownerKey.size())),
+        line.substr(pBank + bankKey.size())};
+
+    // 2) Intestazione delle colonne
+    if (pos >= text.size()) throw std::runtime_error("Missing CSV header");
+    nextLine(text, pos);
+    return preamble;
+}
+
+bool CsvReader::next(TransactionRecord& out) {
+    if (pos >= text.size()) return false;
+    const std::string_view line = nextLine(text, pos);
+    if (line.starts_with("Summary")) {
+        pos = text.size();
+        summaryReached = true;
+        return false; // ignora il sommario
+    }
+    parseLine(line, out);
+    return true;
+}
+
+namespace {
+
+constexpr std::size_t kBatchRows = 4096;
+
+// Analizza un intero blocco di righe; si ferma alla prima riga non valida o al sommario
+struct ChunkResult {
+    std::string_view text;
+    std::vector<TransactionRecord> records;
+    std::vector<TransactionStore::FieldCodes> codes;   // solo se richiesti
+    std::exception_ptr error;
+    bool summary = false;
+    bool done = false;
+};
+
+void internAll(std::span<const TransactionRecord> records, std::vector<TransactionStore::FieldCodes>& codes) {
+    codes.clear();
+    codes.reserve(records.size());
+    for (const auto& r : records) codes.push_back(TransactionStore::intern(r));
+}
+
+void parseChunk(ChunkResult& chunk, bool intern) {
+    CsvReader reader(chunk.text);
+    TransactionRecord record;
+    try {
+        while (reader.next(record)) {
+            chunk.records.push_back(record);
+        }
+        chunk.summary = reader.reachedSummary();
+    } catch (...) {
+        chunk.error = std::current_exception();
+    }
+    // Anche le righe prima di un errore arrivano a sink: servono i loro codici
+    if (intern) {
+        try {
+            internAll(chunk.records, chunk.codes);
+        } catch (...) {
+            chunk.error = std::current_exception();
+            chunk.records.clear();
+            chunk.codes.clear();
+        }
+    }
+}
+
+}
+
+void CsvReader::readAll(const BatchSink& sink, unsigned threads) {
+    readBatches([&](std::span<const TransactionRecord> batch, std::span<const TransactionStore::FieldCodes>) {
+        sink(batch);
+    }, threads, false);
+}
+
+void CsvReader::readAllInterned(const InternedBatchSink& sink, unsigned threads) {
+    readBatches(sink, threads, true);
+}
+
+void CsvReader::readBatches(const InternedBatchSink& sink, unsigned threads, bool intern) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::string_view rest = text.substr(pos);
+
+    if (threads == 1 || rest.size() < (1u << 20)) {
+        std::vector<TransactionRecord> batch;
+        std::vector<TransactionStore::FieldCodes> codes;
+        batch.reserve(kBatchRows);
+        const auto deliver = [&] {
+            if (intern) internAll(batch, codes);
+            sink(batch, codes);
+            batch.clear();
+        };
+        TransactionRecord record;
+        for (;;) {
+            // Solo gli errori di parsing consegnano le righe precedenti: se è sink a
+            // lanciare, il blocco non va ripassato
+            bool more;
+            try {
+                more = next(record);
+            } catch (...) {
+                deliver();
+                throw;
+            }
+            if (!more) break;
+            batch.push_back(record);
+            if (batch.size() == kBatchRows) deliver();
+        }
+        deliver();
+        return;
+    }
+
+    // Divisione in blocchi a fine riga (più blocchi che thread, per bilanciare)
+    std::vector<ChunkResult> chunks;
+    const std::size_t target = std::max<std::size_t>(rest.size() / (threads * 4), 1u << 16);
+    for (std::size_t begin = 0; begin < rest.size();) {
+        std::size_t end = std::min(begin + target, rest.size());
+        if (end < rest.size()) {
+            const char* nl = findByte(rest.data() + end, rest.data() + rest.size(), '\n');
+            end = static_cast<std::size_t>(nl - rest.data()) + (nl == rest.data() + rest.size() ? 0 : 1);
+        }
+        chunks.emplace_back().text = rest.substr(begin, end - begin);
+        begin = end;
+    }
+
+    // I worker analizzano al massimo `window` blocchi oltre l'ultimo consegnato a sink
+    std::mutex m;
+    std::condition_variable cv;
+    std::size_t nextChunk = 0;
+    std::size_t merged = 0;
+    bool stop = false;
+    const std::size_t window = static_cast<std::size_t>(threads) * 2;
+
+    auto worker = [&] {
+        for (;;) {
+            std::size_t idx;
+            {
+                std::unique_lock lock(m);
+                cv.wait(lock, [&] { return stop || nextChunk >= chunks.size() || nextChunk < merged + window; });
+                if (stop || nextChunk >= chunks.size()) return;
+                idx = nextChunk++;
+            }
+            parseChunk(chunks[idx], intern);
+            {
+                std::lock_guard lock(m);
+                chunks[idx].done = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::jthread> pool;
+    const auto finish = [&] {
+        {
+            std::lock_guard lock(m);
+            stop = true;
+        }
+        cv.notify_all();
+        pool.clear(); // join
+    };
+
+    pool.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) pool.emplace_back(worker);
+
+    // Consegna in ordine di file
+    try {
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            {
+                std::unique_lock lock(m);
+                cv.wait(lock, [&] { return chunks[i].done; });
+            }
+            ChunkResult& chunk = chunks[i];
+            if (intern) {
+                // Un blocco intero per volta: un solo reserve e un solo merge nello store
+                sink(chunk.records, chunk.codes);
+            } else {
+                for (std::size_t r = 0; r < chunk.records.size(); r += kBatchRows) {
+                    const std::size_t n = std::min(kBatchRows, chunk.records.size() - r);
+                    sink(std::span<const TransactionRecord>(chunk.records).subspan(r, n), {});
+                }
+            }
+            if (chunk.error) std::rethrow_exception(chunk.error);
+            if (chunk.summary) {
+                summaryReached = true;
+                break;
+            }
+            std::vector<TransactionRecord>().swap(chunk.records);
+            std::vector<TransactionStore::FieldCodes>().swap(chunk.codes);
+            {
+                std::lock_guard lock(m);
+                merged = i + 1;
+            }
+            cv.notify_all();
+        }
+    } catch (...) {
+        finish();
+        throw;
+    }
+    finish();
+    pos = text.size();
+}
@@ -0,0 +1,65 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_CSV_READER_H
+#define FINANCIAL_TRANSACTIONS_CSV_READER_H
+
+#include <functional>
+#include <span>
+#include <string_view>
+#include "Transaction_Store.h"
+
+// Lettore del CSV scritto da BankAccount::SaveToFile.
+// Lavora sul contenuto del file già in memoria: le celle restituite sono
+// string_view nel buffer originale, nessuna copia per riga.
+class CsvReader {
+private:
+    std::string_view text;
+    std::size_t pos = 0;
+    bool summaryReached = false;
+
+public:
+    struct Preamble {
+        std::string_view owner;
+        std::string_view bank;
+    };
+
+    explicit CsvReader(std::string_view contents) : text(contents) {}
+
+    // Riga "Account Owner: X, Bank: Y" + intestazione delle colonne
+    Preamble readPreamble();
+    // false a fine file o alla riga "Summary"
+    bool next(TransactionRecord& out);
+
+    std::size_t offset() const {
+        return pos;
+    }
+    bool reachedSummary() const {
+        return summaryReached;
+    }
+
+    using BatchSink = std::function<void(std::span<const TransactionRecord>)>;
+    using InternedBatchSink = std::function<void(std::span<const TransactionRecord>,
+                                                 std::span<const TransactionStore::FieldCodes>)>;
+    // Legge tutte le righe rimaste e le passa a sink a blocchi, in ordine di file.
+    // Con threads > 1 il testo viene diviso a fine riga e i blocchi analizzati in parallelo;
+    // errori e stop al sommario restano quelli della lettura sequenziale: le righe
+    // precedenti la prima riga non valida arrivano a sink, poi l'eccezione viene rilanciata.
+    // sink riceve i blocchi su un solo thread.
+    void readAll(const BatchSink& sink, unsigned threads = 1);
+    // Come readAll, con anche TransactionStore::intern() di ogni riga, calcolato dai worker:
+    // a sink resta solo TransactionStore::appendBatch(batch, codes)
+    void readAllInterned(const InternedBatchSink& sink, unsigned threads = 1);
+
+    // Lanciano std::runtime_error con lo stesso messaggio del vecchio parser
+    static void parseLine(std::string_view line, TransactionRecord& out);
+    static TimePoint parseDateTime(std::string_view s);
+    static Money parseAmount(std::string_view s);
+
+private:
+    void readBatches(const InternedBatchSink& sink, unsigned threads, bool intern);
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_CSV_READER_H
@@ -0,0 +1,127 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#include <fcntl.h>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+#include <unistd.h>
+#include "Csv_Writer.h"
+#include "Mapped_File.h"
+
+CsvWriter::CsvWriter(const std::string& filename, Options opts) : options(opts) {
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Error opening file");
+    buffer.reserve(options.bufferSize);
+}
+
+CsvWriter::~CsvWriter() {
+    if (fd < 0) return;
+    try {
+        flush();
+    } catch (...) {
+        // Errori segnalati solo da close()
+    }
+    ::close(fd);
+}
+
+void CsvWriter::flush() {
+    writeAll(fd, buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+void CsvWriter::close() {
+    if (fd < 0) return;
+    flush();
+    if (options.sync && ::fsync(fd) != 0) {
+        throw std::runtime_error("Error syncing file");
+    }
+    const int rc = ::close(fd);
+    fd = -1;
+    if (rc != 0) throw std::runtime_error("Error closing file");
+}
+
+void CsvWriter::appendAmount(Money value) {
+    // Due decimali con la virgola, come il vecchio std::format("{:.2f}") + '.' -> ','
+    char tmp[Money::kMaxChars];
+    buffer.append(tmp, static_cast<std::size_t>(value.toChars(tmp, ',') - tmp));
+}
+
+static void put2(char* p, unsigned v) {
+    p[0] = static_cast<char>('0' + v / 10);
+    p[1] = static_cast<char>('0' + v % 10);
+}
+
+void appendDateTime(std::string& buffer, TimePoint tp) {
+    const auto secs = std::chrono::floor<std::chrono::seconds>(tp);
+    const auto days = std::chrono::floor<std::chrono::days>(secs);
+    const std::chrono::year_month_day ymd{days};
+    const std::chrono::hh_mm_ss hms{secs - days};
+    const int y = static_cast<int>(ymd.year());
+    if (y < 0 || y > 9999) {
+        buffer.append(std::format("{:%Y-%m-%d %H:%M:%S}", tp).substr(0, 19));
+        return;
+    }
+    char out[19];
+    put2(out, static_cast<unsigned>(y) / 100);
+    put2(out + 2, static_cast<unsigned>(y) % 100);
+    out[4] = '-';
+    put2(out + 5, static_cast<unsigned>(ymd.month()));
+    out[7] = '-';
+    put2(out + 8, static_cast<unsigned>(ymd.day()));
+    out[10] = ' ';
+    put2(out + 11, static_cast<unsigned>(hms.hours().count()));
+    out[13] = ':';
+    put2(out + 14, static_cast<unsigned>(hms.minutes().count()));
+    out[16] = ':';
+    put2(out + 17, static_cast<unsigned>(hms.seconds().count()));
+    buffer.append(out, sizeof(out));
+}
+
+void CsvWriter::appendQuoted(std::string_view cell) {
+    buffer.push_back('"');
+    buffer.append(cell);
+    buffer.push_back('"');
+}
+
+void CsvWriter::writePreamble(std::string_view owner, std::string_view bank) {
+    // BOM UTF-8 per Excel
+    buffer.append("\xEF\xBB\xBF");
+    std::format_to(std::back_inserter(buffer), "Account Owner: {}, Bank: {}\n", owner, bank);
+    buffer.append("\"ID\";\"Date\";\"Amount\";\"Operation\";\"Category\";\"Description\";\"Sender\";\"Receiver\"\r\n");
+}
+
+void CsvWriter::writeRow(const TransactionRecord& r) {
+    appendQuoted(r.id);
+    buffer.append(";\"");
+    appendDateTime(buffer, r.data);
+    buffer.append("\";\"");
+    appendAmount(r.amount);
+    buffer.append("\";");
+    appendQuoted(r.operationType);
+    buffer.push_back(';');
+    appendQuoted(r.category);
+    buffer.push_back(';');
+    appendQuoted(r.description);
+    buffer.push_back(';');
+    appendQuoted(r.senderAccount);
+    buffer.push_back(';');
+    appendQuoted(r.receiverAccount);
+    buffer.append("\r\n");
+    if (buffer.size() >= options.bufferSize) flush();
+}
+
+void CsvWriter::writeRow(const TransactionView& t) {
+    writeRow(t.record());
+}
+
+void CsvWriter::writeSummary(Money deposits, Money withdrawals, Money balance) {
+    buffer.append("Summary; Total Deposits: ");
+    appendAmount(deposits);
+    buffer.append(";Total Withdrawals: ");
+    appendAmount(withdrawals);
+    buffer.append(";Final Balance: ");
+    appendAmount(balance);
+    buffer.append("\r\n");
+}
@@ -0,0 +1,51 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_CSV_WRITER_H
+#define FINANCIAL_TRANSACTIONS_CSV_WRITER_H
+
+#include <string>
+#include <string_view>
+#include "Transaction_Store.h"
+
+// "YYYY-MM-DD HH:MM:SS" (troncato ai secondi) in coda a buffer, senza std::format;
+// stesso testo di getDataFormatted().substr(0, 19). Usato anche dai report.
+void appendDateTime(std::string& buffer, TimePoint tp);
+
+// Scrittore del CSV di SaveToFile: formatta direttamente in un buffer riutilizzato
+// e scrive su disco a blocchi grandi. Output identico byte per byte al formato storico.
+class CsvWriter {
+public:
+    struct Options {
+        std::size_t bufferSize = 1 << 20;
+        bool sync = false;   // fsync alla chiusura
+    };
+
+private:
+    int fd = -1;
+    std::string buffer;
+    Options options;
+
+    void flush();
+    void appendAmount(Money value);
+    void appendQuoted(std::string_view cell);
+
+public:
+    explicit CsvWriter(const std::string& filename) : CsvWriter(filename, Options{}) {}
+    CsvWriter(const std::string& filename, Options opts);
+    ~CsvWriter();
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    void writePreamble(std::string_view owner, std::string_view bank);
+    void writeRow(const TransactionRecord& r);
+    void writeRow(const TransactionView& t);
+    void writeSummary(Money deposits, Money withdrawals, Money balance);
+    // Svuota il buffer, esegue fsync se richiesto e chiude; lancia in caso di errore
+    void close();
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_CSV_WRITER_H
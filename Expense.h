@@ -10,17 +10,17 @@
 
 #include "Transaction.h"
 
-class Expense : public Transaction {
+class Expense final : public Transaction {
 public:
-    Expense(std::string idGen, TimePoint d, double i, std::string desc, std::string cat,
+    Expense(std::string idGen, TimePoint d, Money i, std::string desc, std::string cat,
            std::string tipoOp, std::string SendAcc, std::string RecAcc)
-        : Transaction(std::move(idGen), d,i, std::move(desc), std::move(cat), std::move(tipoOp), std::move(SendAcc),std::move( RecAcc)) {}
+        : Transaction(TransactionKind::Expense, std::move(idGen), d,i, std::move(desc), std::move(cat), std::move(tipoOp), std::move(SendAcc),std::move( RecAcc)) {}
 
     std::string getType() const override {
         return "Expense";
     }
-    double getValue() const override{
-        return -amount;
+    Money getValue() const override{
+        return signedValue<TransactionKind::Expense>(amount);
     }
 };
 
@@ -0,0 +1,90 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#include <bit>
+#include <functional>
+#include <stdexcept>
+#include "Id_Index.h"
+#include "Transaction_Store.h"
+
+std::uint32_t IdIndex::hashOf(std::string_view id) {
+    const std::uint64_t h = std::hash<std::string_view>{}(id);
+    return static_cast<std::uint32_t>(h ^ (h >> 32));
+}
+
+std::optional<std::size_t> IdIndex::find(std::string_view id, const StringColumn& ids) const {
+    if (slots.empty()) return std::nullopt;
+    const std::uint32_t h = hashOf(id);
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t pos = h & mask;; pos = (pos + 1) & mask) {
+        const Slot& s = slots[pos];
+        if (s.row == 0) return std::nullopt;
+        if (s.hash == h && ids[s.row - 1] == id) return s.row - 1;
+    }
+}
+
+bool IdIndex::insert(std::string_view id, std::size_t row, const StringColumn& ids) {
+    if (row >= UINT32_MAX) {
+        throw std::length_error("IdIndex: too many transactions");
+    }
+    // Fattore di carico massimo 0.7
+    if ((count + 1) * 10 > slots.size() * 7) grow();
+
+    const std::uint32_t h = hashOf(id);
+    const std::size_t mask = slots.size() - 1;
+    std::size_t pos = h & mask;
+    for (;; pos = (pos + 1) & mask) {
+        const Slot& s = slots[pos];
+        if (s.row == 0) break;
+        if (s.hash == h && ids[s.row - 1] == id) return false;
+    }
+    slots[pos] = Slot{static_cast<std::uint32_t>(row + 1), h};
+    ++count;
+    return true;
+}
+
+void IdIndex::erase(std::string_view id, std::size_t row) {
+    if (slots.empty()) return;
+    const std::size_t mask = slots.size() - 1;
+    std::size_t hole = hashOf(id) & mask;
+    for (;; hole = (hole + 1) & mask) {
+        if (slots[hole].row == 0) return;
+        if (slots[hole].row == row + 1) break;
+    }
+    // Backward shift: niente tombstone, le catene di sondaggio restano contigue
+    for (std::size_t next = (hole + 1) & mask; slots[next].row != 0; next = (next + 1) & mask) {
+        const std::size_t home = slots[next].hash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    }
+    slots[hole] = Slot{0, 0};
+    --count;
+}
+
+void IdIndex::grow() {
+    reserve(count == 0 ? 8 : count * 2);
+}
+
+void IdIndex::reserve(std::size_t rows) {
+    const std::size_t wanted = std::bit_ceil(rows * 10 / 7 + 1);
+    if (wanted <= slots.size()) return;
+
+    // Lo slot dipende solo dall'hash memorizzato: il rehash non rilegge le chiavi
+    std::pmr::vector<Slot> old(wanted, Slot{0, 0}, slots.get_allocator());
+    old.swap(slots);
+    const std::size_t mask = slots.size() - 1;
+    for (const Slot& s : old) {
+        if (s.row == 0) continue;
+        std::size_t pos = s.hash & mask;
+        while (slots[pos].row != 0) pos = (pos + 1) & mask;
+        slots[pos] = s;
+    }
+}
+
+void IdIndex::clear() {
+    slots.clear();
+    count = 0;
+}
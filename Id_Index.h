@@ -0,0 +1,48 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_ID_INDEX_H
+#define FINANCIAL_TRANSACTIONS_ID_INDEX_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+class StringColumn;
+
+// Indice hash sugli ID (open addressing, sondaggio lineare).
+// Ogni slot tiene solo la riga e 32 bit di hash: la chiave vera resta nella
+// colonna degli ID dello store e viene confrontata solo se l'hash coincide.
+class IdIndex {
+private:
+    struct Slot {
+        std::uint32_t row;   // riga + 1, 0 = libero
+        std::uint32_t hash;
+    };
+    std::pmr::vector<Slot> slots;
+    std::size_t count = 0;
+
+    static std::uint32_t hashOf(std::string_view id);
+    void grow();
+
+public:
+    explicit IdIndex(std::pmr::memory_resource* mr = std::pmr::get_default_resource()) : slots(mr) {}
+
+    std::optional<std::size_t> find(std::string_view id, const StringColumn& ids) const;
+    // false se l'ID è già presente (l'indice non viene modificato)
+    bool insert(std::string_view id, std::size_t row, const StringColumn& ids);
+    // Toglie la riga (nessun effetto se assente); gli slot successivi vengono ricompattati
+    void erase(std::string_view id, std::size_t row);
+    void reserve(std::size_t rows);
+    void clear();
+
+    std::size_t size() const {
+        return count;
+    }
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_ID_INDEX_H
@@ -8,17 +8,17 @@
 
 #include "Transaction.h"
 
-class Income : public Transaction {
+class Income final : public Transaction {
 public:
-    Income(std::string idGen, TimePoint d, double i, std::string desc, std::string cat,
+    Income(std::string idGen, TimePoint d, Money i, std::string desc, std::string cat,
             std::string OpType, std::string SendAcc, std::string RecAccount)
-        : Transaction(std::move(idGen), d, i, std::move(desc), std::move(cat), std::move(OpType), std::move(SendAcc), std::move(RecAccount)) {}
+        : Transaction(TransactionKind::Income, std::move(idGen), d, i, std::move(desc), std::move(cat), std::move(OpType), std::move(SendAcc), std::move(RecAccount)) {}
 
     std::string getType() const override{
         return "Income";
     }
-    double getValue() const override{
-        return amount;
+    Money getValue() const override{
+        return signedValue<TransactionKind::Income>(amount);
     }
 };
 
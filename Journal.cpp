@@ -0,0 +1,198 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "Journal.h"
+#include "Mapped_File.h"
+#include "Snapshot.h"
+
+static constexpr char kJournalMagic[8] = {'F', 'T', 'J', 'R', 'N', 'L', '0', '2'};
+static constexpr std::size_t kRecordHeader = 8;
+
+static void dataSync(int fd) {
+#if defined(__linux__)
+    const int rc = ::fdatasync(fd);
+#else
+    const int rc = ::fsync(fd);
+#endif
+    if (rc != 0) throw std::runtime_error("Error syncing journal");
+}
+
+template <class T>
+static void put(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <class T>
+static bool get(std::string_view& in, T& value) {
+    if (in.size() < sizeof(T)) return false;
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+static void encode(std::string& out, const TransactionRecord& r) {
+    const std::size_t start = out.size();
+    out.append(kRecordHeader, '\0');
+    put(out, static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        r.data.time_since_epoch()).count()));
+    put(out, r.amount.cents());
+    put(out, static_cast<std::uint8_t>(r.kind));
+    for (const std::string_view field : {r.id, r.description, r.category, r.operationType,
+                                         r.senderAccount, r.receiverAccount}) {
+        put(out, static_cast<std::uint32_t>(field.size()));
+        out.append(field);
+    }
+    const std::string_view payload = std::string_view(out).substr(start + kRecordHeader);
+    const auto length = static_cast<std::uint32_t>(payload.size());
+    const auto sum = static_cast<std::uint32_t>(snapshot::checksum(payload));
+    std::memcpy(out.data() + start, &length, 4);
+    std::memcpy(out.data() + start + 4, &sum, 4);
+}
+
+static bool decode(std::string_view payload, TransactionRecord& r) {
+    std::int64_t ns = 0, cents = 0;
+    std::uint8_t kind = 0;
+    if (!get(payload, ns) || !get(payload, cents) || !get(payload, kind) || kind > 1) return false;
+    r.amount = Money::fromCents(cents);
+    r.data = TimePoint{std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds{ns})};
+    r.kind = static_cast<TransactionKind>(kind);
+    for (std::string_view* field : {&r.id, &r.description, &r.category, &r.operationType,
+                                    &r.senderAccount, &r.receiverAccount}) {
+        std::uint32_t len = 0;
+        if (!get(payload, len) || payload.size() < len) return false;
+        *field = payload.substr(0, len);
+        payload.remove_prefix(len);
+    }
+    return payload.empty();
+}
+
+TransactionJournal::TransactionJournal(const std::string& filename) {
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) throw std::runtime_error("Error opening journal: " + filename);
+
+    struct stat st{};
+    char magic[sizeof(kJournalMagic)] = {};
+    try {
+        if (::fstat(fd, &st) != 0) throw std::runtime_error("Error opening journal: " + filename);
+        if (st.st_size == 0) {
+            writeAll(fd, kJournalMagic, sizeof(kJournalMagic));
+            dataSync(fd);
+        } else if (::pread(fd, magic, sizeof(magic), 0) != static_cast<ssize_t>(sizeof(magic)) ||
+                   std::memcmp(magic, kJournalMagic, sizeof(magic)) != 0) {
+            throw std::runtime_error("Invalid journal: bad magic in " + filename);
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+TransactionJournal::~TransactionJournal() {
+    // I record non ancora attesi con waitDurable() vengono comunque scritti
+    try {
+        std::lock_guard lock(m);
+        if (!failure && !pending.empty()) writeAll(fd, pending.data(), pending.size());
+    } catch (...) {
+    }
+    ::close(fd);
+}
+
+std::uint64_t TransactionJournal::append(const TransactionRecord& r) {
+    std::lock_guard lock(m);
+    if (failure) std::rethrow_exception(failure);
+    encode(pending, r);
+    return ++lastLsn;
+}
+
+void TransactionJournal::waitDurable(std::uint64_t lsn) {
+    std::unique_lock lock(m);
+    while (durableLsn < lsn) {
+        if (failure) std::rethrow_exception(failure);
+        if (flushing) {
+            cv.wait(lock);
+            continue;
+        }
+        // Questo thread diventa il leader del gruppo: scrive tutto ciò che è in coda
+        flushing = true;
+        std::string batch;
+        batch.swap(pending);
+        const std::uint64_t upTo = lastLsn;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            writeAll(fd, batch.data(), batch.size());
+            dataSync(fd);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        flushing = false;
+        ++syncs;
+        if (error) failure = error;
+        else       durableLsn = upTo;
+        cv.notify_all();
+    }
+}
+
+std::size_t TransactionJournal::replay(const std::function<void(const TransactionRecord&)>& apply) {
+    std::unique_lock lock(m);
+    cv.wait(lock, [&] { return !flushing; });
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) throw std::runtime_error("Error reading journal");
+    std::vector<char> bytes(static_cast<std::size_t>(st.st_size));
+    for (std::size_t done = 0; done < bytes.size();) {
+        const ssize_t n = ::pread(fd, bytes.data() + done, bytes.size() - done, static_cast<off_t>(done));
+        if (n <= 0) throw std::runtime_error("Error reading journal");
+        done += static_cast<std::size_t>(n);
+    }
+
+    const std::string_view all(bytes.data(), bytes.size());
+    if (all.size() < sizeof(kJournalMagic)) throw std::runtime_error("Invalid journal: truncated magic");
+    std::size_t offset = sizeof(kJournalMagic);
+    std::size_t applied = 0;
+    TransactionRecord record;
+    while (all.size() - offset >= kRecordHeader) {
+        std::uint32_t length = 0, sum = 0;
+        std::memcpy(&length, all.data() + offset, 4);
+        std::memcpy(&sum, all.data() + offset + 4, 4);
+        if (all.size() - offset - kRecordHeader < length) break;
+        const std::string_view payload = all.substr(offset + kRecordHeader, length);
+        if (static_cast<std::uint32_t>(snapshot::checksum(payload)) != sum || !decode(payload, record)) break;
+        apply(record);
+        ++applied;
+        offset += kRecordHeader + length;
+    }
+
+    // Coda interrotta da un crash: si riparte dall'ultimo record integro
+    if (offset < all.size()) {
+        if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            throw std::runtime_error("Error truncating journal");
+        }
+        dataSync(fd);
+    }
+    return applied;
+}
+
+void TransactionJournal::reset() {
+    std::unique_lock lock(m);
+    cv.wait(lock, [&] { return !flushing; });
+    pending.clear();
+    if (::ftruncate(fd, static_cast<off_t>(sizeof(kJournalMagic))) != 0) {
+        throw std::runtime_error("Error truncating journal");
+    }
+    dataSync(fd);
+    durableLsn = lastLsn;
+    cv.notify_all();
+}
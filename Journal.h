@@ -0,0 +1,60 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_JOURNAL_H
+#define FINANCIAL_TRANSACTIONS_JOURNAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "Transaction_Store.h"
+
+// Journal append-only delle transazioni accettate (write-ahead log).
+// File: magic di 8 byte, poi record [lunghezza u32][checksum u32][payload].
+// Thread-safe: append() mette in coda in memoria, waitDurable() scrive e fa fdatasync;
+// chi arriva mentre un altro thread sta sincronizzando aspetta il giro successivo,
+// così molte append concorrenti condividono una sola fdatasync (group commit).
+class TransactionJournal {
+private:
+    int fd = -1;
+    std::mutex m;
+    std::condition_variable cv;
+    std::string pending;
+    std::uint64_t lastLsn = 0;
+    std::uint64_t durableLsn = 0;
+    std::uint64_t syncs = 0;
+    bool flushing = false;
+    std::exception_ptr failure;
+
+public:
+    explicit TransactionJournal(const std::string& filename);
+    ~TransactionJournal();
+
+    TransactionJournal(const TransactionJournal&) = delete;
+    TransactionJournal& operator=(const TransactionJournal&) = delete;
+
+    // Numero di sequenza del record, durevole solo dopo waitDurable()
+    std::uint64_t append(const TransactionRecord& r);
+    void waitDurable(std::uint64_t lsn);
+    void commit(const TransactionRecord& r) {
+        waitDurable(append(r));
+    }
+
+    // Applica i record validi in ordine; una coda troncata o corrotta
+    // (scrittura interrotta) viene tagliata dal file. Restituisce i record applicati.
+    std::size_t replay(const std::function<void(const TransactionRecord&)>& apply);
+    // Svuota il journal, ad esempio dopo uno snapshot
+    void reset();
+
+    std::uint64_t syncCount() {
+        std::lock_guard lock(m);
+        return syncs;
+    }
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_JOURNAL_H
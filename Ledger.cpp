@@ -0,0 +1,164 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <mutex>
+#include <stdexcept>
+#include "Ledger.h"
+#include "Journal.h"
+
+BankAccount& Ledger::openAccount(const std::string& owner, const std::string& bank, const std::string& pwd) {
+    Shard& shard = shards[shardOf(bank)];
+    std::unique_lock lock(shard.mutex);
+    auto [it, inserted] = shard.accounts.try_emplace(bank);
+    if (!inserted) {
+        throw std::runtime_error("Account already exists: " + bank);
+    }
+    try {
+        it->second = std::make_unique<BankAccount>(owner, bank, pwd, resource);
+    } catch (...) {
+        shard.accounts.erase(it);
+        throw;
+    }
+    return *it->second;
+}
+
+BankAccount* Ledger::find(std::string_view bank) const {
+    const Shard& shard = shards[shardOf(bank)];
+    std::shared_lock lock(shard.mutex);
+    const auto it = shard.accounts.find(bank);
+    return it == shard.accounts.end() ? nullptr : it->second.get();
+}
+
+BankAccount& Ledger::require(std::string_view bank) const {
+    BankAccount* account = find(bank);
+    if (!account) {
+        throw std::invalid_argument("Unknown account: " + std::string(bank));
+    }
+    return *account;
+}
+
+std::size_t Ledger::size() const {
+    std::size_t n = 0;
+    for (const Shard& shard : shards) {
+        std::shared_lock lock(shard.mutex);
+        n += shard.accounts.size();
+    }
+    return n;
+}
+
+void Ledger::forEach(const std::function<void(BankAccount&)>& f) const {
+    for (const Shard& shard : shards) {
+        std::shared_lock lock(shard.mutex);
+        for (const auto& [bank, account] : shard.accounts) {
+            f(*account);
+        }
+    }
+}
+
+Money Ledger::totalBalance() const {
+    Money total{};
+    forEach([&](BankAccount& account) { total += account.balance(); });
+    return total;
+}
+
+// Le due gambe di un trasferimento: "<id>-OUT" su from, "<id>-IN" su to
+struct TransferLegs {
+    std::string outId;
+    std::string inId;
+    TransactionRecord out;
+    TransactionRecord in;
+
+    TransferLegs(std::string_view from, std::string_view to, Money amount, std::string_view id,
+                 std::string_view description, TimePoint when)
+        : outId(std::string(id) + "-OUT"), inId(std::string(id) + "-IN"),
+          out{outId, when, amount, TransactionKind::Expense, description, "Transfer", "Expense", from, to},
+          in{inId, when, amount, TransactionKind::Income, description, "Transfer", "Income", from, to} {}
+    // I record puntano negli ID qui sopra
+    TransferLegs(const TransferLegs&) = delete;
+    TransferLegs& operator=(const TransferLegs&) = delete;
+};
+
+void Ledger::transfer(std::string_view from, std::string_view to, Money amount, std::string_view id,
+                      std::string_view description, TimePoint when) {
+    BankAccount& sender = require(from);
+    BankAccount& receiver = require(to);
+    if (amount <= Money{}) {
+        throw std::runtime_error("Invalid amount: transfer must be positive");
+    }
+    sender.validateTransfer(&receiver);
+
+    const TransferLegs legs(from, to, amount, id, description, when);
+    const TransactionRecord& out = legs.out;
+    const TransactionRecord& in = legs.in;
+
+    std::shared_lock journalLock(journalMutex);
+    // Ordine globale per bank ID: due trasferimenti opposti non si bloccano a vicenda
+    const bool senderFirst = from < to;
+    BankAccount::WriteLock first(senderFirst ? sender : receiver);
+    BankAccount::WriteLock second(senderFirst ? receiver : sender);
+
+    if (!journal && (sender.journal || receiver.journal)) {
+        throw std::runtime_error("Transfer between journaled accounts requires a ledger journal");
+    }
+    sender.checkRules(sender.totals.balance, out.kind, out.value(), true, &receiver);
+    if (sender.transactions.containsId(legs.outId)) {
+        throw std::runtime_error("Duplicate transaction ID: " + legs.outId);
+    }
+    if (receiver.transactions.containsId(legs.inId)) {
+        throw std::runtime_error("Duplicate transaction ID: " + legs.inId);
+    }
+
+    // Un solo record nel journal del Ledger per entrambe le gambe, durevole prima che i
+    // totali cambino e che i lock vengano rilasciati: se append o fdatasync falliscono
+    // lo store torna com'era e su disco non resta nessuna gamba (né una sola).
+    // L'attesa sotto lock costa una fdatasync per coppia di conti, condivisa fra
+    // trasferimenti concorrenti su coppie diverse.
+    const std::size_t receiverRows = receiver.transactions.size();
+    const std::size_t outRow = sender.transactions.append(out);
+    std::size_t inRow;
+    try {
+        inRow = receiver.transactions.append(in);
+        if (journal) journal->commit(out);
+    } catch (...) {
+        sender.transactions.truncate(outRow);
+        receiver.transactions.truncate(receiverRows);
+        throw;
+    }
+    sender.accumulate(sender.transactions[outRow]);
+    receiver.accumulate(receiver.transactions[inRow]);
+}
+
+void Ledger::attachJournal(std::shared_ptr<TransactionJournal> j) {
+    std::unique_lock lock(journalMutex);
+    journal = std::move(j);
+}
+
+void Ledger::Recover(const std::string& journalFile) {
+    std::unique_lock lock(journalMutex);
+    auto recovered = std::make_shared<TransactionJournal>(journalFile);
+    recovered->replay([&](const TransactionRecord& r) {
+        if (!r.id.ends_with("-OUT")) {
+            throw std::runtime_error("Invalid transfer journal record: " + std::string(r.id));
+        }
+        const TransferLegs legs(r.senderAccount, r.receiverAccount, r.amount, r.id.substr(0, r.id.size() - 4),
+                                r.description, r.data);
+        // Gambe già negli snapshot dei conti (checkpoint successivo al trasferimento) si saltano
+        for (const auto& [bank, leg] : {std::pair{r.senderAccount, &legs.out},
+                                        std::pair{r.receiverAccount, &legs.in}}) {
+            BankAccount& account = require(bank);
+            BankAccount::WriteLock accountLock(account);
+            if (!account.transactions.containsId(leg->id)) {
+                account.accumulate(account.transactions[account.transactions.append(*leg)]);
+            }
+        }
+    });
+    journal = std::move(recovered);
+}
+
+void Ledger::Checkpoint(const std::function<void(BankAccount&)>& checkpoint) {
+    // Nessun trasferimento fra gli snapshot dei conti e lo svuotamento del journal
+    std::unique_lock lock(journalMutex);
+    forEach(checkpoint);
+    if (journal) journal->reset();
+}
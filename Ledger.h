@@ -0,0 +1,89 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_LEDGER_H
+#define FINANCIAL_TRANSACTIONS_LEDGER_H
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Bank_Account.h"
+
+// Insieme di conti indicizzati per bank ID, con trasferimenti a due gambe atomici.
+// Il registro è diviso in shard (un lock ciascuno): le ricerche di conti diversi
+// non si contendono un mutex globale. I conti non vengono mai rimossi, quindi i
+// riferimenti restituiti restano validi per tutta la vita del Ledger.
+class Ledger {
+public:
+    // mr: risorsa passata a ogni conto aperto (deve sopravvivere al Ledger)
+    explicit Ledger(std::pmr::memory_resource* mr = std::pmr::get_default_resource()) : resource(mr) {}
+
+    Ledger(const Ledger&) = delete;
+    Ledger& operator=(const Ledger&) = delete;
+
+    // Lancia std::runtime_error se il bank ID è già registrato
+    BankAccount& openAccount(const std::string& owner, const std::string& bank, const std::string& pwd);
+    // nullptr se il conto non esiste
+    BankAccount* find(std::string_view bank) const;
+    std::size_t size() const;
+
+    // Registra l'uscita "<id>-OUT" su from e l'entrata "<id>-IN" su to, tutto o niente:
+    // i due conti restano bloccati in scrittura (in ordine di bank ID, senza deadlock)
+    // dalla validazione fino all'inserimento di entrambe le gambe.
+    // Conto inesistente: std::invalid_argument; saldo insufficiente, stesso conto,
+    // importo non positivo o ID già presente: std::runtime_error (nessuna gamba registrata).
+    // Con il journal del Ledger le gambe non passano dai journal dei conti e ritorna solo
+    // quando il trasferimento è su disco; senza, fra conti con journal lancia
+    // std::runtime_error (le due gambe non avrebbero un commit comune).
+    void transfer(std::string_view from, std::string_view to, Money amount, std::string_view id,
+                  std::string_view description, TimePoint when = Clock::now());
+
+    // Journal dei trasferimenti: un record per trasferimento (la gamba "-OUT", da cui si
+    // ricava "-IN"), quindi le due gambe diventano durevoli insieme
+    void attachJournal(std::shared_ptr<TransactionJournal> j);
+    // Dopo BankAccount::Recover di ogni conto (tutti già aperti): riapplica i trasferimenti
+    // del journal che mancano (per ID) e lascia il journal attaccato
+    void Recover(const std::string& journalFile);
+    // Con i trasferimenti fermi: checkpoint(conto) per ogni conto (es. BankAccount::Checkpoint),
+    // poi svuota il journal dei trasferimenti
+    void Checkpoint(const std::function<void(BankAccount&)>& checkpoint);
+
+    // Somma dei saldi: coerente se non ci sono trasferimenti in corso
+    Money totalBalance() const;
+    void forEach(const std::function<void(BankAccount&)>& f) const;
+
+private:
+    static constexpr std::size_t kShards = 64;
+
+    struct KeyHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<BankAccount>, KeyHash, std::equal_to<>> accounts;
+    };
+
+    std::pmr::memory_resource* resource;
+    std::array<Shard, kShards> shards;
+    // Condiviso dai trasferimenti, esclusivo per cambiare o svuotare il journal
+    mutable std::shared_mutex journalMutex;
+    std::shared_ptr<TransactionJournal> journal;
+
+    static std::size_t shardOf(std::string_view bank) {
+        return KeyHash{}(bank) % kShards;
+    }
+    BankAccount& require(std::string_view bank) const;
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_LEDGER_H
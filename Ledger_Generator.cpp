@@ -0,0 +1,375 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "Csv_Writer.h"
+#include "Ledger_Generator.h"
+
+namespace {
+
+// splitmix64: mescolamento e generatore di flusso (stesso risultato su ogni piattaforma)
+std::uint64_t mix(std::uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+class Random {
+private:
+    std::uint64_t state;
+public:
+    explicit Random(std::uint64_t seed) : state(seed) {}
+    std::uint64_t next() {
+        const std::uint64_t z = state;
+        state += 0x9E3779B97F4A7C15ull;
+        return mix(z);
+    }
+    // Uniforme in [0, 1)
+    double unit() {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+    // Uniforme in [0, bound)
+    std::uint64_t below(std::uint64_t bound) {
+        return static_cast<std::uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+    }
+};
+
+std::string numbered(std::string_view prefix, std::size_t n, std::size_t width) {
+    std::string digits = std::to_string(n);
+    if (digits.size() < width) digits.insert(0, width - digits.size(), '0');
+    return std::string(prefix) + digits;
+}
+
+std::vector<double> weightsOf(const std::vector<LedgerGenerator::Weighted>& items) {
+    std::vector<double> w;
+    w.reserve(items.size());
+    for (const auto& item : items) w.push_back(item.weight);
+    return w;
+}
+
+// Conti 0..count-1 distribuiti su un pool di thread; Stats sommate, primo errore rilanciato
+LedgerGenerator::Stats forEachAccount(std::size_t count, unsigned threads,
+                                      const std::function<LedgerGenerator::Stats(std::size_t)>& f) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+    std::atomic<std::size_t> next{0};
+    std::mutex m;
+    LedgerGenerator::Stats total;
+    std::exception_ptr error;
+    const auto work = [&] {
+        LedgerGenerator::Stats local;
+        try {
+            for (std::size_t a = next++; a < count; a = next++) local += f(a);
+        } catch (...) {
+            next = count;
+            std::lock_guard lock(m);
+            if (!error) error = std::current_exception();
+        }
+        std::lock_guard lock(m);
+        total += local;
+    };
+    if (threads <= 1) {
+        work();
+    } else {
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; ++t) pool.emplace_back(work);
+        for (auto& t : pool) t.join();
+    }
+    if (error) std::rethrow_exception(error);
+    return total;
+}
+
+}
+
+LedgerGenerator::Stats& LedgerGenerator::Stats::operator+=(const Stats& other) {
+    rows += other.rows;
+    transferLegs += other.transferLegs;
+    topUps += other.topUps;
+    deposits += other.deposits;
+    withdrawals += other.withdrawals;
+    bytes += other.bytes;
+    return *this;
+}
+
+void LedgerGenerator::AliasTable::build(std::span<const double> weights) {
+    const std::size_t n = weights.size();
+    double sum = 0;
+    for (const double w : weights) {
+        if (!(w >= 0)) throw std::invalid_argument("Weights must be non-negative");
+        sum += w;
+    }
+    if (n == 0 || n > UINT32_MAX || !(sum > 0)) throw std::invalid_argument("Weights must have a positive sum");
+
+    threshold.assign(n, UINT32_MAX);
+    alias.resize(n);
+    std::vector<double> scaled(n);
+    std::vector<std::uint32_t> small, large;
+    for (std::size_t i = 0; i < n; ++i) {
+        alias[i] = static_cast<std::uint32_t>(i);
+        scaled[i] = weights[i] * static_cast<double>(n) / sum;
+        (scaled[i] < 1 ? small : large).push_back(static_cast<std::uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()) {
+        const std::uint32_t s = small.back();
+        small.pop_back();
+        const std::uint32_t l = large.back();
+        threshold[s] = static_cast<std::uint32_t>(std::max(0.0, scaled[s]) * 0x1.0p32);
+        alias[s] = l;
+        scaled[l] -= 1 - scaled[s];
+        if (scaled[l] < 1) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Resti (arrotondamenti): probabilità piena
+}
+
+std::uint32_t LedgerGenerator::AliasTable::sample(std::uint64_t random) const {
+    const auto i = static_cast<std::uint32_t>(((random >> 32) * threshold.size()) >> 32);
+    return static_cast<std::uint32_t>(random) < threshold[i] ? i : alias[i];
+}
+
+std::vector<std::int64_t> LedgerGenerator::logSteps(Money min, Money max) {
+    std::vector<std::int64_t> steps(kAmountSteps + 1);
+    const double lo = std::log(static_cast<double>(min.cents()));
+    const double hi = std::log(static_cast<double>(max.cents()));
+    for (std::size_t i = 0; i <= kAmountSteps; ++i) {
+        steps[i] = std::llround(std::exp(lo + (hi - lo) * static_cast<double>(i) / kAmountSteps));
+    }
+    steps.front() = min.cents();
+    steps.back() = max.cents();
+    return steps;
+}
+
+std::int64_t LedgerGenerator::stepAmount(const std::vector<std::int64_t>& steps, std::uint64_t random) {
+    // 12 bit alti: quantile (kAmountSteps = 4096); gli altri: posizione nell'intervallo
+    static_assert(kAmountSteps == 1u << 12);
+    const std::size_t i = random >> 52;
+    const std::int64_t lo = steps[i];
+    const std::int64_t width = steps[i + 1] - lo + 1;
+    return lo + static_cast<std::int64_t>((random & ((1ull << 52) - 1)) % static_cast<std::uint64_t>(width));
+}
+
+LedgerGenerator::LedgerGenerator(Options opts) : config(std::move(opts)) {
+    const std::size_t n = config.accounts;
+    if (n == 0 || n > UINT32_MAX) throw std::invalid_argument("Invalid number of accounts");
+    if (config.counterparties == 0) throw std::invalid_argument("At least one counterparty is required");
+    if (config.span.count() <= 0 || config.span.count() > UINT32_MAX) throw std::invalid_argument("Invalid time span");
+    if (!(config.transferShare >= 0 && config.transferShare <= 1) ||
+        !(config.incomeShare >= 0 && config.incomeShare <= 1)) {
+        throw std::invalid_argument("Shares must be between 0 and 1");
+    }
+    for (const auto& [min, max] : {std::pair{config.incomeMin, config.incomeMax},
+                                   std::pair{config.expenseMin, config.expenseMax},
+                                   std::pair{config.transferMin, config.transferMax}}) {
+        if (min <= Money{} || max < min) throw std::invalid_argument("Invalid amount range");
+    }
+
+    owners.reserve(n);
+    banks.reserve(n);
+    for (std::size_t a = 0; a < n; ++a) {
+        owners.push_back(numbered("Owner", a, 6));
+        banks.push_back(numbered("IT60X0542811101", a, 8));
+    }
+    externals.reserve(config.counterparties);
+    for (std::size_t c = 0; c < config.counterparties; ++c) {
+        externals.push_back(numbered("EXT", c, 8));
+    }
+    for (const auto& c : config.incomeCategories) incomeDescriptions.push_back("Credit: " + c.name);
+    for (const auto& c : config.expenseCategories) expenseDescriptions.push_back("Card payment: " + c.name);
+
+    incomeCategoryTable.build(weightsOf(config.incomeCategories));
+    expenseCategoryTable.build(weightsOf(config.expenseCategories));
+    std::vector<double> zipf(config.counterparties);
+    for (std::size_t c = 0; c < zipf.size(); ++c) {
+        zipf[c] = 1 / std::pow(static_cast<double>(c + 1), config.counterpartySkew);
+    }
+    counterpartyTable.build(zipf);
+    expenseSteps = logSteps(config.expenseMin, config.expenseMax);
+    transferSteps = logSteps(config.transferMin, config.transferMax);
+
+    // Coppie di trasferimento: servono almeno due conti
+    transferCount = n < 2 ? 0 : static_cast<std::uint64_t>(
+        static_cast<double>(config.transactions) * config.transferShare / 2);
+    if (transferCount > UINT32_MAX) throw std::invalid_argument("Too many transfers");
+    regularRows = config.transactions - 2 * transferCount;
+
+    // Indice per conto in due passate (conteggio, poi riempimento) e ordinamento per tempo
+    transferFirst.assign(n + 1, 0);
+    for (std::uint64_t k = 0; k < transferCount; ++k) {
+        const Transfer t = transfer(k);
+        ++transferFirst[t.from + 1];
+        ++transferFirst[t.to + 1];
+    }
+    for (std::size_t a = 0; a < n; ++a) transferFirst[a + 1] += transferFirst[a];
+    transferRefs.resize(2 * transferCount);
+    std::vector<std::uint64_t> fill(transferFirst.begin(), transferFirst.end() - 1);
+    for (std::uint64_t k = 0; k < transferCount; ++k) {
+        const Transfer t = transfer(k);
+        const TransferRef ref{t.offset, static_cast<std::uint32_t>(k)};
+        transferRefs[fill[t.from]++] = ref;
+        transferRefs[fill[t.to]++] = ref;
+    }
+    for (std::size_t a = 0; a < n; ++a) {
+        std::sort(transferRefs.begin() + static_cast<std::ptrdiff_t>(transferFirst[a]),
+                  transferRefs.begin() + static_cast<std::ptrdiff_t>(transferFirst[a + 1]),
+                  [](const TransferRef& x, const TransferRef& y) {
+                      return x.offset < y.offset || (x.offset == y.offset && x.index < y.index);
+                  });
+    }
+}
+
+LedgerGenerator::Transfer LedgerGenerator::transfer(std::uint64_t index) const {
+    const std::uint64_t n = banks.size();
+    const std::uint64_t h1 = mix(config.seed ^ mix(index ^ 0x5452414E53464552ull));
+    const std::uint64_t h2 = mix(h1);
+    const std::uint64_t h3 = mix(h2);
+    const std::uint64_t h4 = mix(h3);
+    const auto from = static_cast<std::uint32_t>(((h1 >> 32) * n) >> 32);
+    const auto to = static_cast<std::uint32_t>((from + 1 + (((h2 >> 32) * (n - 1)) >> 32)) % n);
+    const auto offset = static_cast<std::uint32_t>(h3 % static_cast<std::uint64_t>(config.span.count()));
+    return Transfer{from, to, offset, Money::fromCents(stepAmount(transferSteps, h4))};
+}
+
+LedgerGenerator::Stats LedgerGenerator::generate(
+        std::size_t account, const std::function<void(std::span<const TransactionRecord>)>& emit) const {
+    constexpr std::size_t kBatch = 4096;
+    constexpr std::size_t kIdChars = 40;
+
+    const std::size_t n = banks.size();
+    const std::string& own = banks[account];
+    const std::uint64_t rows = regularRows / n + (account < regularRows % n ? 1 : 0);
+    const double secondsPerRow = static_cast<double>(config.span.count()) / static_cast<double>(std::max<std::uint64_t>(rows, 1));
+    const std::span<const TransferRef> refs(transferRefs.data() + transferFirst[account],
+                                            transferRefs.data() + transferFirst[account + 1]);
+    Random rng(mix(config.seed ^ mix(static_cast<std::uint64_t>(account) * 2 + 1)));
+
+    Stats stats;
+    Money balance;
+    std::vector<TransactionRecord> batch;
+    batch.reserve(kBatch);
+    std::vector<std::array<char, kIdChars>> ids(kBatch);
+
+    // ID nel buffer della posizione corrente del blocco: prefix + numero + suffix
+    const auto makeId = [&](std::string_view prefix, std::uint64_t number, std::string_view suffix) {
+        char* first = ids[batch.size()].data();
+        char* p = std::copy(prefix.begin(), prefix.end(), first);
+        p = std::to_chars(p, first + kIdChars, number).ptr;
+        p = std::copy(suffix.begin(), suffix.end(), p);
+        return std::string_view(first, static_cast<std::size_t>(p - first));
+    };
+    const auto push = [&](const TransactionRecord& r) {
+        batch.push_back(r);
+        ++stats.rows;
+        if (r.kind == TransactionKind::Income) stats.deposits += r.amount;
+        else                                   stats.withdrawals += r.amount;
+        balance += r.value();
+        if (batch.size() == kBatch) {
+            emit(batch);
+            batch.clear();
+        }
+    };
+    const std::string accountPrefix = "A" + std::to_string(account) + "-";
+    const std::string topUpPrefix = "A" + std::to_string(account) + "-T";
+    const auto coverExpense = [&](Money amount, TimePoint when) {
+        if (balance >= amount) return;
+        const Money topUp = amount - balance + config.incomeMin;
+        push(TransactionRecord{makeId(topUpPrefix, stats.topUps++, {}), when, topUp, TransactionKind::Income,
+                               "Automatic top-up", "Top-up", "Income", own, own});
+    };
+
+    std::uint64_t k = 0;
+    std::size_t j = 0;
+    std::uint64_t regularOffset = 0;
+    bool haveOffset = false;
+    while (k < rows || j < refs.size()) {
+        if (k < rows && !haveOffset) {
+            // Uno per intervallo di span / rows secondi: crescenti senza ordinare
+            regularOffset = static_cast<std::uint64_t>((static_cast<double>(k) + rng.unit()) * secondsPerRow);
+            regularOffset = std::min<std::uint64_t>(regularOffset, static_cast<std::uint64_t>(config.span.count()) - 1);
+            haveOffset = true;
+        }
+        if (j < refs.size() && (k == rows || refs[j].offset < regularOffset)) {
+            const std::uint32_t index = refs[j++].index;
+            const Transfer t = transfer(index);
+            const TimePoint when = config.start + std::chrono::seconds{t.offset};
+            if (t.from == account) {
+                coverExpense(t.amount, when);
+                push(TransactionRecord{makeId("TR", index, "-OUT"), when, t.amount, TransactionKind::Expense,
+                                       "Transfer between accounts", "Transfer", "Expense", own, banks[t.to]});
+            } else {
+                push(TransactionRecord{makeId("TR", index, "-IN"), when, t.amount, TransactionKind::Income,
+                                       "Transfer between accounts", "Transfer", "Income", banks[t.from], own});
+            }
+            ++stats.transferLegs;
+            continue;
+        }
+
+        const TimePoint when = config.start + std::chrono::seconds{regularOffset};
+        const std::string& other = externals[counterpartyTable.sample(rng.next())];
+        if (rng.unit() < config.incomeShare) {
+            const std::uint32_t c = incomeCategoryTable.sample(rng.next());
+            const Money amount = config.incomeMin + Money::fromCents(static_cast<std::int64_t>(
+                rng.below(static_cast<std::uint64_t>((config.incomeMax - config.incomeMin).cents()) + 1)));
+            push(TransactionRecord{makeId(accountPrefix, k, {}), when, amount, TransactionKind::Income,
+                                   incomeDescriptions[c], config.incomeCategories[c].name, "Income", other, own});
+        } else {
+            const std::uint32_t c = expenseCategoryTable.sample(rng.next());
+            const Money amount = Money::fromCents(stepAmount(expenseSteps, rng.next()));
+            coverExpense(amount, when);
+            push(TransactionRecord{makeId(accountPrefix, k, {}), when, amount, TransactionKind::Expense,
+                                   expenseDescriptions[c], config.expenseCategories[c].name, "Expense", own, other});
+        }
+        ++k;
+        haveOffset = false;
+    }
+    if (!batch.empty()) emit(batch);
+    return stats;
+}
+
+LedgerGenerator::Stats LedgerGenerator::writeCsv(std::size_t account, const std::string& filename) const {
+    CsvWriter file(filename);
+    file.writePreamble(owners[account], banks[account]);
+    Stats stats = generate(account, [&](std::span<const TransactionRecord> batch) {
+        for (const auto& r : batch) file.writeRow(r);
+    });
+    file.writeSummary(stats.deposits, stats.withdrawals, stats.deposits - stats.withdrawals);
+    file.close();
+    stats.bytes = std::filesystem::file_size(filename);
+    return stats;
+}
+
+LedgerGenerator::Stats LedgerGenerator::writeAll(const std::string& directory, unsigned threads) const {
+    std::filesystem::create_directories(directory);
+    return forEachAccount(banks.size(), threads, [&](std::size_t a) {
+        return writeCsv(a, (std::filesystem::path(directory) / (banks[a] + ".csv")).string());
+    });
+}
+
+LedgerGenerator::Stats LedgerGenerator::feed(std::size_t account, BankAccount& target, const std::string& pwd) const {
+    return generate(account, [&](std::span<const TransactionRecord> batch) {
+        target.importRecords(batch, pwd);
+    });
+}
+
+LedgerGenerator::Stats LedgerGenerator::populate(Ledger& ledger, const std::string& pwd, unsigned threads) const {
+    std::vector<BankAccount*> accounts;
+    accounts.reserve(banks.size());
+    for (std::size_t a = 0; a < banks.size(); ++a) {
+        accounts.push_back(&ledger.openAccount(owners[a], banks[a], pwd));
+    }
+    return forEachAccount(banks.size(), threads, [&](std::size_t a) {
+        return feed(a, *accounts[a], pwd);
+    });
+}
@@ -0,0 +1,150 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_LEDGER_GENERATOR_H
+#define FINANCIAL_TRANSACTIONS_LEDGER_GENERATOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+#include "Bank_Account.h"
+#include "Ledger.h"
+
+// Generatore deterministico di conti e transazioni sintetici per i test di carico.
+// Stesse opzioni (seed compreso) -> stessi dati byte per byte, qualunque sia il numero
+// di thread: ogni conto ha il proprio flusso pseudo-casuale e i trasferimenti sono
+// funzioni pure del loro indice, quindi i conti si generano in modo indipendente.
+//
+// Ogni conto esce in ordine temporale, al secondo (come nel CSV), con saldo mai negativo:
+// se una spesa o un trasferimento in uscita lo renderebbe negativo viene prima inserita
+// una ricarica ("Top-up"), unica riga in più rispetto a quelle richieste.
+class LedgerGenerator {
+public:
+    struct Weighted {
+        std::string name;
+        double weight = 1;
+    };
+
+    struct Options {
+        std::uint64_t seed = 42;
+        std::size_t accounts = 100;
+        // Righe totali richieste: le due gambe di un trasferimento contano due
+        std::uint64_t transactions = 1'000'000;
+        TimePoint start = std::chrono::sys_days{std::chrono::year{2025} / 1 / 1};
+        std::chrono::seconds span = std::chrono::days{365};
+        // Quota di righe che sono gambe di trasferimenti fra conti generati ("<id>-OUT"/"<id>-IN",
+        // categoria "Transfer", come Ledger::transfer); delle altre, quota di entrate
+        double transferShare = 0.1;
+        double incomeShare = 0.2;
+        std::vector<Weighted> incomeCategories{{"Salary", 70}, {"Refund", 20}, {"Interest", 10}};
+        std::vector<Weighted> expenseCategories{{"Food", 30}, {"Shopping", 17}, {"Transport", 15},
+                                                {"Leisure", 14}, {"Utilities", 10}, {"Rent", 8},
+                                                {"Health", 6}};
+        // Conti esterni come controparti di entrate e spese, scelti con legge di Zipf
+        // (skew 0 = uniforme; più alto = poche controparti molto frequenti)
+        std::size_t counterparties = 10000;
+        double counterpartySkew = 1.0;
+        // Entrate uniformi, spese e trasferimenti log-uniformi fra minimo e massimo
+        Money incomeMin = Money::fromCents(50000);
+        Money incomeMax = Money::fromCents(350000);
+        Money expenseMin = Money::fromCents(100);
+        Money expenseMax = Money::fromCents(50000);
+        Money transferMin = Money::fromCents(1000);
+        Money transferMax = Money::fromCents(100000);
+    };
+
+    struct Stats {
+        std::uint64_t rows = 0;
+        std::uint64_t transferLegs = 0;
+        std::uint64_t topUps = 0;
+        Money deposits;
+        Money withdrawals;
+        std::uint64_t bytes = 0;        // solo per i file scritti
+
+        Stats& operator+=(const Stats& other);
+    };
+
+    // Lancia std::invalid_argument se le opzioni non sono coerenti
+    explicit LedgerGenerator(Options opts);
+
+    const Options& options() const {
+        return config;
+    }
+    std::size_t accountCount() const {
+        return banks.size();
+    }
+    const std::string& owner(std::size_t account) const {
+        return owners[account];
+    }
+    const std::string& bank(std::size_t account) const {
+        return banks[account];
+    }
+
+    // Righe del conto in ordine temporale, a blocchi: i record puntano in buffer interni,
+    // validi solo durante la chiamata a emit. Sicuro da più thread in parallelo.
+    Stats generate(std::size_t account, const std::function<void(std::span<const TransactionRecord>)>& emit) const;
+
+    // CSV nel formato esatto di SaveToFile (preambolo, righe, sommario)
+    Stats writeCsv(std::size_t account, const std::string& filename) const;
+    // Un file "<bank>.csv" per conto in directory (creata se manca); threads = 0: tutti i core
+    Stats writeAll(const std::string& directory, unsigned threads = 0) const;
+
+    // Direttamente in memoria, senza passare dal CSV: stesso contenuto di ReadFromFile sul file
+    Stats feed(std::size_t account, BankAccount& target, const std::string& pwd) const;
+    // Apre tutti i conti nel Ledger (password pwd) e li riempie
+    Stats populate(Ledger& ledger, const std::string& pwd, unsigned threads = 0) const;
+
+private:
+    // Campionamento O(1) da una distribuzione discreta (metodo di Walker/Vose)
+    class AliasTable {
+    private:
+        std::vector<std::uint32_t> threshold;
+        std::vector<std::uint32_t> alias;
+    public:
+        void build(std::span<const double> weights);
+        std::uint32_t sample(std::uint64_t random) const;
+    };
+
+    struct Transfer {
+        std::uint32_t from;
+        std::uint32_t to;
+        std::uint32_t offset;       // secondi da start
+        Money amount;
+    };
+    // Riferimento di un conto a un trasferimento, in ordine di (offset, indice)
+    struct TransferRef {
+        std::uint32_t offset;
+        std::uint32_t index;
+    };
+
+    static constexpr std::size_t kAmountSteps = 4096;
+
+    Options config;
+    std::vector<std::string> owners;
+    std::vector<std::string> banks;
+    std::vector<std::string> externals;
+    std::vector<std::string> incomeDescriptions;
+    std::vector<std::string> expenseDescriptions;
+    AliasTable incomeCategoryTable;
+    AliasTable expenseCategoryTable;
+    AliasTable counterpartyTable;
+    // Quantili delle distribuzioni log-uniformi (interpolati in interi: niente exp per riga)
+    std::vector<std::int64_t> expenseSteps;
+    std::vector<std::int64_t> transferSteps;
+    // Trasferimenti per conto (CSR): refs[first[a] .. first[a + 1])
+    std::uint64_t transferCount = 0;
+    std::vector<std::uint64_t> transferFirst;
+    std::vector<TransferRef> transferRefs;
+    std::uint64_t regularRows = 0;
+
+    Transfer transfer(std::uint64_t index) const;
+    static std::vector<std::int64_t> logSteps(Money min, Money max);
+    static std::int64_t stepAmount(const std::vector<std::int64_t>& steps, std::uint64_t random);
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_LEDGER_GENERATOR_H
@@ -0,0 +1,50 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Mapped_File.h"
+
+MappedFile::MappedFile(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Error opening file");
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Error opening file");
+    }
+    length = static_cast<std::size_t>(st.st_size);
+    if (length > 0) {
+        void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Error mapping file: " + filename);
+        }
+        ::madvise(p, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(p);
+    }
+    // La mappatura resta valida anche dopo la chiusura del descrittore
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data) ::munmap(const_cast<char*>(data), length);
+}
+
+void writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Error writing file");
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
@@ -0,0 +1,36 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_MAPPED_FILE_H
+#define FINANCIAL_TRANSACTIONS_MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+
+// File in sola lettura mappato in memoria (POSIX mmap), chiuso dal distruttore
+class MappedFile {
+private:
+    const char* data = nullptr;
+    std::size_t length = 0;
+
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view view() const {
+        return {data, length};
+    }
+    std::size_t size() const {
+        return length;
+    }
+};
+
+// write(2) ripetuta finché tutti i byte sono scritti; lancia std::runtime_error
+void writeAll(int fd, const char* data, std::size_t size);
+
+
+#endif //FINANCIAL_TRANSACTIONS_MAPPED_FILE_H
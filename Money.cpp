@@ -0,0 +1,82 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "Money.h"
+
+Money Money::fromDouble(double units) {
+    const double scaled = std::round(units * kScale);
+    // 2^63 è esattamente rappresentabile: tutto ciò che è sotto sta in un int64
+    constexpr double limit = 9223372036854775808.0;
+    if (!std::isfinite(scaled) || scaled >= limit || scaled < -limit) {
+        throw std::runtime_error("Invalid amount: out of range");
+    }
+    return Money{static_cast<std::int64_t>(scaled)};
+}
+
+Money Money::parse(std::string_view s) {
+    const auto invalid = [&] {
+        return std::runtime_error("Invalid amount: " + std::string(s));
+    };
+    const char* p = s.data();
+    const char* end = p + s.size();
+    const bool negative = p != end && *p == '-';
+    if (p != end && (*p == '-' || *p == '+')) ++p;
+
+    // Al massimo 17 cifre intere: il totale in centesimi sta in un uint64
+    std::uint64_t units = 0;
+    const char* digits = p;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        if (p - digits == 17) throw invalid();
+        units = units * 10 + static_cast<unsigned>(*p - '0');
+    }
+    if (p == digits) throw invalid();
+
+    std::uint64_t fraction = 0;
+    if (p != end && (*p == ',' || *p == '.')) {
+        ++p;
+        const char* decimals = p;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            if (p - decimals == 2) throw invalid();
+            fraction = fraction * 10 + static_cast<unsigned>(*p - '0');
+        }
+        if (p == decimals) throw invalid();
+        if (p - decimals == 1) fraction *= 10;
+    }
+    if (p != end) throw invalid();
+
+    const std::uint64_t cents = units * kScale + fraction;
+    constexpr auto max = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+    if (cents > max + (negative ? 1 : 0)) throw invalid();
+    return Money{negative ? static_cast<std::int64_t>(0 - cents) : static_cast<std::int64_t>(cents)};
+}
+
+char* Money::toChars(char* first, char decimalSeparator) const {
+    // Modulo in unsigned: vale anche per il minimo int64
+    std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value)
+                                        : static_cast<std::uint64_t>(value);
+    if (value < 0) *first++ = '-';
+
+    const auto fraction = static_cast<unsigned>(magnitude % kScale);
+    magnitude /= kScale;
+    char digits[20];
+    char* d = digits + sizeof(digits);
+    do {
+        *--d = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    for (; d != digits + sizeof(digits); ++d) *first++ = *d;
+
+    *first++ = decimalSeparator;
+    *first++ = static_cast<char>('0' + fraction / 10);
+    *first++ = static_cast<char>('0' + fraction % 10);
+    return first;
+}
+
+std::string Money::toString(char decimalSeparator) const {
+    char buf[kMaxChars];
+    return {buf, toChars(buf, decimalSeparator)};
+}
@@ -0,0 +1,75 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_MONEY_H
+#define FINANCIAL_TRANSACTIONS_MONEY_H
+
+#include <compare>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Importo a virgola fissa: intero a 64 bit di centesimi.
+// Somme esatte e indipendenti dall'ordine (anche fra thread); nessuna conversione
+// implicita da/verso double, si passa da fromDouble()/toDouble().
+class Money {
+private:
+    std::int64_t value = 0;
+
+    constexpr explicit Money(std::int64_t cents) : value(cents) {}
+
+public:
+    static constexpr std::int64_t kScale = 100;
+    // Spazio sufficiente per toChars(): segno, 17 cifre intere, separatore, 2 decimali
+    static constexpr std::size_t kMaxChars = 24;
+
+    constexpr Money() = default;
+
+    static constexpr Money fromCents(std::int64_t cents) {
+        return Money{cents};
+    }
+    // Arrotonda al centesimo più vicino; lancia std::runtime_error se non rappresentabile
+    static Money fromDouble(double units);
+    // "[-]123[,|.]45" con 0-2 decimali, solo aritmetica intera
+    static Money parse(std::string_view s);
+
+    constexpr std::int64_t cents() const {
+        return value;
+    }
+    constexpr double toDouble() const {
+        return static_cast<double>(value) / kScale;
+    }
+
+    // Scrive sempre due decimali con il separatore indicato; restituisce la fine
+    char* toChars(char* first, char decimalSeparator = '.') const;
+    std::string toString(char decimalSeparator = '.') const;
+
+    constexpr Money operator-() const {
+        return Money{-value};
+    }
+    constexpr Money& operator+=(Money other) {
+        value += other.value;
+        return *this;
+    }
+    constexpr Money& operator-=(Money other) {
+        value -= other.value;
+        return *this;
+    }
+    friend constexpr Money operator+(Money a, Money b) {
+        return a += b;
+    }
+    friend constexpr Money operator-(Money a, Money b) {
+        return a -= b;
+    }
+    friend constexpr auto operator<=>(Money, Money) = default;
+};
+
+inline std::ostream& operator<<(std::ostream& os, Money m) {
+    char buf[Money::kMaxChars];
+    return os.write(buf, m.toChars(buf) - buf);
+}
+
+
+#endif //FINANCIAL_TRANSACTIONS_MONEY_H
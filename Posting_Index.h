@@ -0,0 +1,71 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_POSTING_INDEX_H
+#define FINANCIAL_TRANSACTIONS_POSTING_INDEX_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Indice secondario: per ogni chiave la lista (crescente) delle righe che la contengono.
+// Le chiavi sono codici di StringDictionary, condivisi da tutti i conti: un conto ne usa
+// pochi su un dizionario che può contenerne milioni (es. i conti controparte di un
+// Ledger), quindi codice -> lista passa da una piccola tabella hash, non da un array
+// grande quanto il dizionario.
+class PostingIndex {
+private:
+    std::pmr::vector<std::pmr::vector<std::uint32_t>> lists;
+    std::pmr::unordered_map<std::uint32_t, std::uint32_t> slots;
+    std::size_t keys = 0;
+    // Ultima chiave vista: le righe consecutive ripetono spesso lo stesso codice
+    std::uint32_t lastKey = 0;
+    std::uint32_t lastSlot = UINT32_MAX;
+
+    std::uint32_t slotOf(std::uint32_t key) {
+        if (lastSlot != UINT32_MAX && key == lastKey) return lastSlot;
+        const auto [it, inserted] = slots.try_emplace(key, static_cast<std::uint32_t>(lists.size()));
+        if (inserted) lists.emplace_back();
+        lastKey = key;
+        lastSlot = it->second;
+        return it->second;
+    }
+
+public:
+    explicit PostingIndex(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : lists(mr), slots(mr) {}
+
+    void add(std::uint32_t key, std::size_t row) {
+        auto& list = lists[slotOf(key)];
+        if (list.empty()) ++keys;
+        list.push_back(static_cast<std::uint32_t>(row));
+    }
+    std::span<const std::uint32_t> find(std::uint32_t key) const {
+        const auto it = slots.find(key);
+        if (it == slots.end()) return {};
+        return lists[it->second];
+    }
+    // Toglie le righe >= firstRow (sono sempre in coda alle liste)
+    void truncate(std::size_t firstRow) {
+        for (auto& list : lists) {
+            if (list.empty()) continue;
+            while (!list.empty() && list.back() >= firstRow) list.pop_back();
+            if (list.empty()) --keys;
+        }
+    }
+    std::size_t keyCount() const {
+        return keys;
+    }
+    void clear() {
+        lists.clear();
+        slots.clear();
+        keys = 0;
+        lastSlot = UINT32_MAX;
+    }
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_POSTING_INDEX_H
@@ -0,0 +1,122 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <stdexcept>
+#include "Csv_Writer.h"
+#include "Mapped_File.h"
+#include "Report_Renderer.h"
+
+void StreamSink::write(std::string_view bytes) {
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) throw std::runtime_error("Error writing report");
+}
+
+void FdSink::write(std::string_view bytes) {
+    writeAll(fd, bytes.data(), bytes.size());
+}
+
+ReportRenderer::ReportRenderer(ReportSink& s, Options opts) : sink(s), options(opts) {
+    buffer.reserve(options.bufferSize);
+}
+
+ReportRenderer::~ReportRenderer() {
+    try {
+        flush();
+    } catch (...) {
+        // Chi vuole l'errore chiama flush() prima della distruzione
+    }
+}
+
+void ReportRenderer::flush() {
+    if (buffer.empty()) return;
+    sink.write(buffer);
+    buffer.clear();
+}
+
+void ReportRenderer::appendAmount(Money m) {
+    char tmp[Money::kMaxChars];
+    buffer.append(tmp, static_cast<std::size_t>(m.toChars(tmp) - tmp));
+}
+
+void ReportRenderer::appendEscaped(std::string_view text) {
+    for (const char c : text) {
+        switch (c) {
+            case '\t': buffer.append("\\t"); break;
+            case '\n': buffer.append("\\n"); break;
+            case '\\': buffer.append("\\\\"); break;
+            default: buffer.push_back(c);
+        }
+    }
+}
+
+void ReportRenderer::header() {
+    if (options.format == ReportFormat::Pretty) buffer.append("\n--- Transaction List ---\n");
+}
+
+void ReportRenderer::stage(const TransactionView& t) {
+    ++rows;
+    if (options.format == ReportFormat::Pretty) {
+        buffer.append("ID: ").append(t.getId());
+        buffer.append("\nDate: ");
+        appendDateTime(buffer, t.getData());
+        buffer.append("\nAmount: ");
+        appendAmount(t.getAmount());
+        buffer.append("\nOperation: ").append(t.getOperationType());
+        buffer.append("\nCategory: ").append(t.getCategory());
+        buffer.append("\nDescription: ").append(t.getDescription());
+        buffer.append("\nSender: ").append(t.getSenderAccount());
+        buffer.append("\nReceiver: ").append(t.getReceiverAccount());
+        buffer.append("\n\n");
+    } else {
+        appendEscaped(t.getId());
+        buffer.push_back('\t');
+        appendDateTime(buffer, t.getData());
+        buffer.push_back('\t');
+        buffer.append(t.getType());
+        buffer.push_back('\t');
+        appendAmount(t.getAmount());
+        buffer.push_back('\t');
+        appendEscaped(t.getCategory());
+        buffer.push_back('\t');
+        appendEscaped(t.getOperationType());
+        buffer.push_back('\t');
+        appendEscaped(t.getSenderAccount());
+        buffer.push_back('\t');
+        appendEscaped(t.getReceiverAccount());
+        buffer.push_back('\t');
+        appendEscaped(t.getDescription());
+        buffer.push_back('\n');
+    }
+}
+
+void ReportRenderer::noResults() {
+    // Nel formato compatto un risultato vuoto è semplicemente nessuna riga
+    if (options.format == ReportFormat::Pretty) buffer.append("No transactions found\n");
+}
+
+void ReportRenderer::summary(Money deposits, Money withdrawals, Money balance) {
+    if (options.format == ReportFormat::Compact) {
+        buffer.append("#summary\t");
+        appendAmount(deposits);
+        buffer.push_back('\t');
+        appendAmount(withdrawals);
+        buffer.push_back('\t');
+        appendAmount(balance);
+        buffer.push_back('\n');
+        return;
+    }
+    const bool color = options.color;
+    buffer.append("----------------------------------------------\n");
+    buffer.append("Total Deposits: ");
+    if (color) buffer.append("\x1b[38;2;0;100;0m");
+    appendAmount(deposits);
+    if (color) buffer.append("\x1b[0m");
+    buffer.append("\n Total Withdrawals: ");
+    if (color) buffer.append("\x1b[38;2;139;0;0m");
+    appendAmount(withdrawals);
+    if (color) buffer.append("\x1b[0m");
+    buffer.append("\nBalance: ");
+    appendAmount(balance);
+    buffer.push_back('\n');
+}
@@ -0,0 +1,104 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_REPORT_RENDERER_H
+#define FINANCIAL_TRANSACTIONS_REPORT_RENDERER_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "Transaction_Store.h"
+
+// Destinazione dei byte di un report
+class ReportSink {
+public:
+    virtual ~ReportSink() = default;
+    virtual void write(std::string_view bytes) = 0;
+};
+
+class StreamSink final : public ReportSink {
+private:
+    std::ostream& out;
+public:
+    explicit StreamSink(std::ostream& os) : out(os) {}
+    void write(std::string_view bytes) override;
+};
+
+// File descriptor già aperto (non viene chiuso)
+class FdSink final : public ReportSink {
+private:
+    int fd;
+public:
+    explicit FdSink(int descriptor) : fd(descriptor) {}
+    void write(std::string_view bytes) override;
+};
+
+// Accoda a una stringa del chiamante
+class StringSink final : public ReportSink {
+private:
+    std::string& out;
+public:
+    explicit StringSink(std::string& s) : out(s) {}
+    void write(std::string_view bytes) override {
+        out.append(bytes);
+    }
+};
+
+// Pretty: il formato storico di printTransactions (colori ANSI opzionali).
+// Compact: una riga per transazione, campi separati da tab
+//   id, data, Income|Expense, importo, categoria, operazione, mittente, destinatario, descrizione
+// (tab, a capo e backslash nei testi diventano \t, \n, \\), più "#summary" in coda.
+enum class ReportFormat { Pretty, Compact };
+
+// Formatta le righe in un unico buffer riutilizzato e lo passa al sink a blocchi:
+// niente std::format né scritture su stream per riga.
+class ReportRenderer {
+public:
+    struct Options {
+        ReportFormat format = ReportFormat::Pretty;
+        bool color = true;                // solo Pretty
+        std::size_t bufferSize = 64 << 10;
+    };
+
+    explicit ReportRenderer(ReportSink& s) : ReportRenderer(s, Options{}) {}
+    ReportRenderer(ReportSink& s, Options opts);
+    // Svuota il buffer; gli errori di scrittura emergono solo da flush()
+    ~ReportRenderer();
+
+    ReportRenderer(const ReportRenderer&) = delete;
+    ReportRenderer& operator=(const ReportRenderer&) = delete;
+
+    void header();
+    void row(const TransactionView& t) {
+        stage(t);
+        maybeFlush();
+    }
+    // Solo formattazione nel buffer, nessuna scrittura sul sink (per chi tiene un lock)
+    void stage(const TransactionView& t);
+    bool full() const {
+        return buffer.size() >= options.bufferSize;
+    }
+    void noResults();
+    void summary(Money deposits, Money withdrawals, Money balance);
+    void flush();
+
+    std::size_t rowCount() const {
+        return rows;
+    }
+
+private:
+    ReportSink& sink;
+    Options options;
+    std::string buffer;
+    std::size_t rows = 0;
+
+    void appendAmount(Money m);
+    void appendEscaped(std::string_view text);
+    void maybeFlush() {
+        if (full()) flush();
+    }
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_REPORT_RENDERER_H
@@ -0,0 +1,123 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include "Rollup_Index.h"
+
+using namespace std::chrono;
+
+std::int32_t RollupIndex::dayIndex(TimePoint t) {
+    return static_cast<std::int32_t>(floor<days>(t).time_since_epoch().count());
+}
+
+std::int32_t RollupIndex::monthIndex(std::int32_t day) {
+    const year_month_day ymd{sys_days{days{day}}};
+    return static_cast<int>(ymd.year()) * 12 + static_cast<int>(static_cast<unsigned>(ymd.month())) - 1;
+}
+
+std::int32_t RollupIndex::firstDayOfMonth(std::int32_t month) {
+    const int y = month >= 0 ? month / 12 : (month - 11) / 12;
+    const unsigned m = static_cast<unsigned>(month - y * 12) + 1;
+    return static_cast<std::int32_t>(sys_days{year{y} / m / 1}.time_since_epoch().count());
+}
+
+std::int32_t RollupIndex::monthOfDay(std::int32_t day) {
+    if (day != lastDay) {
+        lastDay = day;
+        lastMonth = monthIndex(day);
+    }
+    return lastMonth;
+}
+
+void RollupIndex::add(TimePoint when, std::uint32_t categoryCode, TransactionKind kind, Money amount) {
+    const std::int32_t day = dayIndex(when);
+    Value& d = dayBuckets[Key{day, categoryCode, kind}];
+    d.sum += amount;
+    ++d.count;
+    Value& m = monthBuckets[Key{monthOfDay(day), categoryCode, kind}];
+    m.sum += amount;
+    ++m.count;
+}
+
+void RollupIndex::add(const TransactionView& t) {
+    add(t.getData(), t.getCategoryCode(), t.getKind(), t.getAmount());
+}
+
+void RollupIndex::rebuild(const TransactionStore& store) {
+    clear();
+    const auto dates = store.timestamps();
+    const auto categories = store.categoryCodes();
+    const auto kinds = store.kinds();
+    const auto amounts = store.amounts();
+    for (std::size_t row = 0; row < store.size(); ++row) {
+        add(dates[row], categories[row], kinds[row], amounts[row]);
+    }
+}
+
+void RollupIndex::clear() {
+    dayBuckets.clear();
+    monthBuckets.clear();
+    lastDay = INT32_MIN;
+}
+
+std::vector<Rollup> RollupIndex::buckets(RollupPeriod period, TimePoint from, TimePoint to) const {
+    const bool daily = period == RollupPeriod::Day;
+    const Buckets& source = daily ? dayBuckets : monthBuckets;
+    const std::int32_t first = daily ? dayIndex(from) : monthIndex(dayIndex(from));
+    const StringDictionary& dictionary = StringDictionary::shared();
+
+    std::vector<Rollup> out;
+    for (auto it = source.lower_bound(Key{first, 0, TransactionKind::Income}); it != source.end(); ++it) {
+        const std::int32_t startDay = daily ? it->first.bucket : firstDayOfMonth(it->first.bucket);
+        const TimePoint start = sys_days{days{startDay}};
+        if (start >= to) break;
+        out.push_back(Rollup{start, dictionary[it->first.category], it->first.kind, it->second.sum,
+                             it->second.count});
+    }
+    return out;
+}
+
+std::vector<CategoryRollup> RollupIndex::byCategory(TimePoint from, TimePoint to) const {
+    std::map<std::uint32_t, CategoryRollup> totals;
+    const auto take = [&](const Buckets& source, std::int32_t first, std::int32_t last) {
+        for (auto it = source.lower_bound(Key{first, 0, TransactionKind::Income});
+             it != source.end() && it->first.bucket < last; ++it) {
+            CategoryRollup& c = totals[it->first.category];
+            if (it->first.kind == TransactionKind::Income) {
+                c.income += it->second.sum;
+                c.incomeCount += it->second.count;
+            } else {
+                c.expense += it->second.sum;
+                c.expenseCount += it->second.count;
+            }
+        }
+    };
+
+    // Giorni [d, end): mesi interi in un colpo, il resto giorno per giorno
+    std::int32_t d = dayIndex(from);
+    const std::int32_t end = dayIndex(to);
+    while (d < end) {
+        const std::int32_t month = monthIndex(d);
+        const std::int32_t nextMonth = firstDayOfMonth(month + 1);
+        if (d == firstDayOfMonth(month) && nextMonth <= end) {
+            take(monthBuckets, month, month + 1);
+            d = nextMonth;
+        } else {
+            const std::int32_t stop = std::min(nextMonth, end);
+            take(dayBuckets, d, stop);
+            d = stop;
+        }
+    }
+
+    const StringDictionary& dictionary = StringDictionary::shared();
+    std::vector<CategoryRollup> out;
+    out.reserve(totals.size());
+    for (auto& [code, c] : totals) {
+        c.category = std::string(dictionary[code]);
+        out.push_back(std::move(c));
+    }
+    std::ranges::sort(out, {}, &CategoryRollup::category);
+    return out;
+}
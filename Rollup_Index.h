@@ -0,0 +1,85 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_ROLLUP_INDEX_H
+#define FINANCIAL_TRANSACTIONS_ROLLUP_INDEX_H
+
+#include <compare>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "Transaction_Store.h"
+
+enum class RollupPeriod { Day, Month };
+
+// Un bucket: periodo (giorno o mese UTC) x categoria x tipo
+struct Rollup {
+    TimePoint start;            // inizio del giorno o del mese
+    std::string_view category;
+    TransactionKind kind;
+    Money sum;                  // somma degli importi (positivi)
+    std::uint64_t count = 0;
+};
+
+// Totali di una categoria su un intervallo
+struct CategoryRollup {
+    std::string category;
+    Money income;
+    Money expense;
+    std::uint64_t incomeCount = 0;
+    std::uint64_t expenseCount = 0;
+};
+
+// Aggregati materializzati per giorno e per mese, aggiornati a ogni inserimento:
+// i report per periodo e categoria leggono i bucket, non le righe.
+class RollupIndex {
+public:
+    explicit RollupIndex(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : dayBuckets(mr), monthBuckets(mr) {}
+
+    void add(TimePoint when, std::uint32_t categoryCode, TransactionKind kind, Money amount);
+    void add(const TransactionView& t);
+    // Ricostruzione in una passata sulle colonne (dopo un caricamento in blocco)
+    void rebuild(const TransactionStore& store);
+    void clear();
+
+    // Bucket del periodo con inizio in [inizio del bucket di from, to), in ordine di tempo
+    std::vector<Rollup> buckets(RollupPeriod period, TimePoint from, TimePoint to) const;
+    // Per categoria (in ordine di nome) sui giorni UTC interi da from a to escluso:
+    // i mesi completi vengono dai bucket mensili, i bordi da quelli giornalieri
+    std::vector<CategoryRollup> byCategory(TimePoint from, TimePoint to) const;
+
+    std::size_t bucketCount(RollupPeriod period) const {
+        return period == RollupPeriod::Day ? dayBuckets.size() : monthBuckets.size();
+    }
+
+private:
+    struct Key {
+        std::int32_t bucket;        // giorni dall'epoch, oppure anno * 12 + mese - 1
+        std::uint32_t category;
+        TransactionKind kind;
+        auto operator<=>(const Key&) const = default;
+    };
+    struct Value {
+        Money sum;
+        std::uint64_t count = 0;
+    };
+    using Buckets = std::pmr::map<Key, Value>;
+
+    Buckets dayBuckets;
+    Buckets monthBuckets;
+    // Ultimo giorno convertito in mese: righe consecutive cadono quasi sempre nello stesso
+    std::int32_t lastDay = INT32_MIN;
+    std::int32_t lastMonth = 0;
+
+    std::int32_t monthOfDay(std::int32_t day);
+    static std::int32_t dayIndex(TimePoint t);
+    static std::int32_t monthIndex(std::int32_t day);
+    static std::int32_t firstDayOfMonth(std::int32_t month);
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_ROLLUP_INDEX_H
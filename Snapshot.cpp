@@ -0,0 +1,226 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include "Csv_Reader.h"
+#include "Csv_Writer.h"
+#include "Snapshot.h"
+
+namespace snapshot {
+
+std::uint64_t checksum(std::string_view bytes) {
+    constexpr std::uint64_t prime = 0x9E3779B97F4A7C15ull;
+    std::uint64_t h = 0xCBF29CE484222325ull ^ (bytes.size() * prime);
+    const char* p = bytes.data();
+    std::size_t left = bytes.size();
+    for (; left >= 8; p += 8, left -= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        h = (h ^ w) * prime;
+        h ^= h >> 29;
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, p, left);
+    h = (h ^ tail) * prime;
+    return h ^ (h >> 32);
+}
+
+static void syncDirectory(const std::string& filename) {
+    std::string dir = std::filesystem::path(filename).parent_path().string();
+    if (dir.empty()) dir = ".";
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Error opening directory: " + dir);
+    const int rc = ::fsync(fd);
+    ::close(fd);
+    if (rc != 0) throw std::runtime_error("Error syncing directory: " + dir);
+}
+
+void write(const std::string& filename, std::string_view owner, std::string_view bank,
+           const TransactionStore& store, bool sync) {
+    const std::size_t rows = store.size();
+    std::vector<Record> records(rows);
+    std::string strings;
+    strings.append(owner);
+    strings.append(bank);
+
+    const auto amounts = store.amounts();
+    const auto dates = store.timestamps();
+    const auto kinds = store.kinds();
+    for (std::size_t row = 0; row < rows; ++row) {
+        Record& r = records[row];
+        r.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            dates[row].time_since_epoch()).count();
+        r.cents = amounts[row].cents();
+        r.kind = static_cast<std::uint8_t>(kinds[row]);
+        r.stringsOffset = strings.size();
+        const std::string_view fields[6] = {store.id(row), store.description(row), store.category(row),
+                                            store.operationType(row), store.senderAccount(row),
+                                            store.receiverAccount(row)};
+        for (int f = 0; f < 6; ++f) {
+            r.lengths[f] = static_cast<std::uint32_t>(fields[f].size());
+            strings.append(fields[f]);
+        }
+    }
+
+    const std::string_view recordBytes(reinterpret_cast<const char*>(records.data()),
+                                       records.size() * sizeof(Record));
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.byteOrder = kByteOrderMark;
+    h.headerSize = sizeof(Header);
+    h.recordSize = sizeof(Record);
+    h.rowCount = rows;
+    h.recordsOffset = sizeof(Header);
+    h.stringsOffset = h.recordsOffset + recordBytes.size();
+    h.stringsSize = strings.size();
+    h.ownerLength = static_cast<std::uint32_t>(owner.size());
+    h.bankLength = static_cast<std::uint32_t>(bank.size());
+    h.recordsChecksum = checksum(recordBytes);
+    h.stringsChecksum = checksum(strings);
+    h.headerChecksum = checksum({reinterpret_cast<const char*>(&h), offsetof(Header, headerChecksum)});
+
+    // Scrittura su file temporaneo + rename: uno snapshot esistente non resta mai a metà
+    const std::string tmp = filename + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Error opening file");
+    try {
+        writeAll(fd, reinterpret_cast<const char*>(&h), sizeof(h));
+        writeAll(fd, recordBytes.data(), recordBytes.size());
+        writeAll(fd, strings.data(), strings.size());
+        if (sync && ::fsync(fd) != 0) throw std::runtime_error("Error syncing file");
+    } catch (...) {
+        ::close(fd);
+        std::remove(tmp.c_str());
+        throw;
+    }
+    ::close(fd);
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Error renaming snapshot: " + filename);
+    }
+    // Il rename è durevole solo con la directory su disco: chi svuota il journal
+    // dopo lo snapshot non deve poter perdere entrambi
+    if (sync) syncDirectory(filename);
+}
+
+Reader::Reader(const std::string& filename) : file(filename) {
+    const std::string_view bytes = file.view();
+    if (bytes.size() < sizeof(Header)) throw std::runtime_error("Invalid snapshot: truncated header");
+    std::memcpy(&header, bytes.data(), sizeof(Header));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Invalid snapshot: bad magic");
+    }
+    if (header.byteOrder != kByteOrderMark) {
+        throw std::runtime_error("Invalid snapshot: byte order mismatch");
+    }
+    if (header.headerChecksum != checksum(bytes.substr(0, offsetof(Header, headerChecksum)))) {
+        throw std::runtime_error("Invalid snapshot: header checksum mismatch");
+    }
+    if (header.version != kVersion) {
+        throw std::runtime_error("Unsupported snapshot version: " + std::to_string(header.version));
+    }
+    if (header.headerSize != sizeof(Header) || header.recordSize != sizeof(Record) ||
+        header.recordsOffset != sizeof(Header) ||
+        header.rowCount > (bytes.size() - sizeof(Header)) / sizeof(Record) ||
+        header.stringsOffset != header.recordsOffset + header.rowCount * sizeof(Record) ||
+        header.stringsSize != bytes.size() - header.stringsOffset ||
+        std::uint64_t{header.ownerLength} + header.bankLength > header.stringsSize) {
+        throw std::runtime_error("Invalid snapshot: inconsistent sizes");
+    }
+
+    records = bytes.substr(header.recordsOffset, header.rowCount * sizeof(Record));
+    strings = bytes.substr(header.stringsOffset, header.stringsSize);
+    if (checksum(records) != header.recordsChecksum || checksum(strings) != header.stringsChecksum) {
+        throw std::runtime_error("Invalid snapshot: payload checksum mismatch");
+    }
+}
+
+TransactionRecord Reader::record(std::size_t row) const {
+    Record r;
+    std::memcpy(&r, records.data() + row * sizeof(Record), sizeof(Record));
+
+    std::string_view fields[6];
+    std::uint64_t offset = r.stringsOffset;
+    for (int f = 0; f < 6; ++f) {
+        if (offset > strings.size() || r.lengths[f] > strings.size() - offset || r.kind > 1) {
+            throw std::runtime_error("Invalid snapshot: corrupted record " + std::to_string(row));
+        }
+        fields[f] = strings.substr(offset, r.lengths[f]);
+        offset += r.lengths[f];
+    }
+    return TransactionRecord{
+        fields[0],
+        TimePoint{std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds{r.nanoseconds})},
+        Money::fromCents(r.cents), static_cast<TransactionKind>(r.kind),
+        fields[1], fields[2], fields[3], fields[4], fields[5]};
+}
+
+void Reader::readAll(std::vector<TransactionRecord>& records,
+                     std::vector<TransactionStore::FieldCodes>& codes) const {
+    StringDictionary& dictionary = StringDictionary::shared();
+    // Le chiavi puntano nel file mappato, che vive quanto il Reader
+    std::unordered_map<std::string_view, std::uint32_t> seen;
+    const auto code = [&](std::string_view value) {
+        const auto [it, inserted] = seen.try_emplace(value, 0);
+        if (inserted) it->second = dictionary.intern(value);
+        return it->second;
+    };
+    records.clear();
+    codes.clear();
+    records.reserve(rowCount());
+    codes.reserve(rowCount());
+    for (std::size_t row = 0; row < rowCount(); ++row) {
+        const TransactionRecord& r = records.emplace_back(record(row));
+        codes.push_back(TransactionStore::FieldCodes{code(r.category), code(r.operationType),
+                                                     code(r.senderAccount), code(r.receiverAccount)});
+    }
+}
+
+void csvToSnapshot(const std::string& csvFile, const std::string& snapshotFile) {
+    const MappedFile file(csvFile);
+    CsvReader reader(file.view());
+    const auto preamble = reader.readPreamble();
+    TransactionStore store;
+    reader.readAllInterned([&](std::span<const TransactionRecord> batch,
+                               std::span<const TransactionStore::FieldCodes> codes) {
+        store.appendBatch(batch, codes);
+    });
+    write(snapshotFile, preamble.owner, preamble.bank, store);
+}
+
+void snapshotToCsv(const std::string& snapshotFile, const std::string& csvFile) {
+    const Reader reader(snapshotFile);
+    std::vector<TransactionRecord> records;
+    std::vector<TransactionStore::FieldCodes> codes;
+    reader.readAll(records, codes);
+    TransactionStore store;
+    store.appendBatch(records, codes);
+    Money deposits, withdrawals, balance;
+    for (std::size_t row = 0; row < store.size(); ++row) {
+        const Money val = store[row].getValue();
+        if (val >= Money{}) deposits += val;
+        else                withdrawals += -val;
+        balance += val;
+    }
+
+    CsvWriter out(csvFile);
+    out.writePreamble(reader.owner(), reader.bank());
+    for (const auto row : store.rowsByTime()) {
+        out.writeRow(store[row]);
+    }
+    out.writeSummary(deposits, withdrawals, balance);
+    out.close();
+}
+
+}
@@ -0,0 +1,97 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_SNAPSHOT_H
+#define FINANCIAL_TRANSACTIONS_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Mapped_File.h"
+#include "Transaction_Store.h"
+
+// Snapshot binario di un conto.
+// Layout: [header 128 byte][record a larghezza fissa x righe][tabella stringhe]
+// La tabella inizia con owner e bank; per ogni riga i suoi 6 campi testuali sono
+// contigui (id, descrizione, categoria, operazione, mittente, destinatario).
+// Le righe sono in ordine di inserimento.
+namespace snapshot {
+
+inline constexpr char kMagic[8] = {'F', 'T', 'S', 'N', 'A', 'P', '\r', '\n'};
+inline constexpr std::uint32_t kVersion = 2;
+inline constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t headerSize;
+    std::uint32_t recordSize;
+    std::uint64_t rowCount;
+    std::uint64_t recordsOffset;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+    std::uint32_t ownerLength;
+    std::uint32_t bankLength;
+    std::uint64_t recordsChecksum;
+    std::uint64_t stringsChecksum;
+    std::uint8_t reserved[40];
+    std::uint64_t headerChecksum;   // su tutti i byte precedenti
+};
+static_assert(sizeof(Header) == 128);
+
+struct Record {
+    std::int64_t nanoseconds;       // dall'epoca di system_clock
+    std::int64_t cents;             // Money::cents()
+    std::uint64_t stringsOffset;    // inizio dei campi della riga nella tabella
+    std::uint32_t lengths[6];
+    std::uint8_t kind;
+    std::uint8_t reserved[7];
+};
+static_assert(sizeof(Record) == 56);
+
+// Hash a 64 bit non crittografico, 8 byte per passo
+std::uint64_t checksum(std::string_view bytes);
+
+// File temporaneo + rename; sync: fsync del file e, dopo il rename, della directory
+void write(const std::string& filename, std::string_view owner, std::string_view bank,
+           const TransactionStore& store, bool sync = true);
+
+// Snapshot aperto in lettura: header, dimensioni e checksum verificati nel costruttore
+class Reader {
+private:
+    MappedFile file;
+    Header header{};
+    std::string_view records;
+    std::string_view strings;
+
+public:
+    explicit Reader(const std::string& filename);
+
+    std::string_view owner() const {
+        return strings.substr(0, header.ownerLength);
+    }
+    std::string_view bank() const {
+        return strings.substr(header.ownerLength, header.bankLength);
+    }
+    std::size_t rowCount() const {
+        return header.rowCount;
+    }
+    TransactionRecord record(std::size_t row) const;
+    // Tutte le righe con i codici del dizionario, pronti per appendBatch(records, codes).
+    // Le stringhe sono ripetute riga per riga nella tabella: ogni valore distinto si
+    // interna una volta sola, non a ogni riga
+    void readAll(std::vector<TransactionRecord>& records,
+                 std::vector<TransactionStore::FieldCodes>& codes) const;
+};
+
+// Conversioni fra il CSV di SaveToFile e lo snapshot (owner e bank presi dal file)
+void csvToSnapshot(const std::string& csvFile, const std::string& snapshotFile);
+void snapshotToCsv(const std::string& snapshotFile, const std::string& csvFile);
+
+}
+
+
+#endif //FINANCIAL_TRANSACTIONS_SNAPSHOT_H
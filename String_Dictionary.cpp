@@ -0,0 +1,77 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <mutex>
+#include <stdexcept>
+#include "String_Dictionary.h"
+
+namespace {
+
+std::atomic<std::uint64_t> nextInstanceId{1};
+
+// Cache per thread delle stringhe già viste: evita lock e contesa sul percorso
+// caldo (import di milioni di righe con poche decine di valori distinti).
+// Le chiavi puntano nello storage del dizionario, che non si sposta mai.
+struct LocalCache {
+    std::uint64_t owner = 0;
+    std::unordered_map<std::string_view, std::uint32_t> codes;
+};
+thread_local LocalCache localCache;
+
+}
+
+StringDictionary::StringDictionary() : instanceId(nextInstanceId.fetch_add(1)) {
+    intern("Income");
+    intern("Expense");
+    intern("Transfer");
+}
+
+StringDictionary& StringDictionary::shared() {
+    static StringDictionary dictionary;
+    return dictionary;
+}
+
+std::optional<std::uint32_t> StringDictionary::find(std::string_view s) const {
+    std::shared_lock lock(m);
+    const auto it = codes.find(s);
+    if (it == codes.end()) return std::nullopt;
+    return it->second;
+}
+
+std::uint32_t StringDictionary::intern(std::string_view s) {
+    LocalCache& cache = localCache;
+    if (cache.owner != instanceId) {
+        cache.codes.clear();
+        cache.owner = instanceId;
+    }
+    if (const auto it = cache.codes.find(s); it != cache.codes.end()) return it->second;
+    const std::uint32_t code = internShared(s);
+    cache.codes.emplace((*this)[code], code);
+    return code;
+}
+
+std::uint32_t StringDictionary::internShared(std::string_view s) {
+    {
+        std::shared_lock lock(m);
+        const auto it = codes.find(s);
+        if (it != codes.end()) return it->second;
+    }
+    std::unique_lock lock(m);
+    // Un altro thread può averla aggiunta fra i due lock
+    if (const auto it = codes.find(s); it != codes.end()) return it->second;
+
+    const std::uint32_t code = count.load(std::memory_order_relaxed);
+    const std::uint32_t chunk = code >> kChunkBits;
+    if (chunk >= kMaxChunks) throw std::runtime_error("String dictionary is full");
+    if ((code & (kChunkSize - 1)) == 0) {
+        ownedChunks.push_back(std::make_unique<std::string_view[]>(kChunkSize));
+        chunks[chunk].store(ownedChunks.back().get(), std::memory_order_release);
+    }
+
+    const std::string_view stored = storage.emplace_back(s);
+    chunks[chunk].load(std::memory_order_relaxed)[code & (kChunkSize - 1)] = stored;
+    codes.emplace(stored, code);
+    count.store(code + 1, std::memory_order_release);
+    return code;
+}
@@ -0,0 +1,78 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_STRING_DICTIONARY_H
+#define FINANCIAL_TRANSACTIONS_STRING_DICTIONARY_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Dizionario di interning per i campi a bassa cardinalità (categoria, tipo di
+// operazione, conti): ogni stringa distinta riceve un codice intero denso, stabile
+// per tutta la vita del processo e condiviso da tutti i conti.
+// intern()/find() sono thread-safe; operator[] non prende lock.
+class StringDictionary {
+public:
+    // Codici fissi, assegnati dal costruttore
+    static constexpr std::uint32_t kIncome = 0;
+    static constexpr std::uint32_t kExpense = 1;
+    static constexpr std::uint32_t kTransfer = 2;
+
+    StringDictionary();
+    StringDictionary(const StringDictionary&) = delete;
+    StringDictionary& operator=(const StringDictionary&) = delete;
+
+    // Dizionario usato da Transaction e TransactionStore
+    static StringDictionary& shared();
+
+    std::uint32_t intern(std::string_view s);
+    // Non aggiunge nulla: una stringa mai vista non ha righe
+    std::optional<std::uint32_t> find(std::string_view s) const;
+
+    // La string_view resta valida finché esiste il dizionario
+    std::string_view operator[](std::uint32_t code) const {
+        return chunks[code >> kChunkBits].load(std::memory_order_acquire)[code & (kChunkSize - 1)];
+    }
+    std::size_t size() const {
+        return count.load(std::memory_order_acquire);
+    }
+
+private:
+    struct KeyHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+
+    // Tabella codice -> stringa a blocchi fissi: un blocco pubblicato non si sposta mai,
+    // quindi la lettura non ha bisogno del mutex
+    static constexpr std::uint32_t kChunkBits = 10;
+    static constexpr std::uint32_t kChunkSize = 1u << kChunkBits;
+    static constexpr std::size_t kMaxChunks = 4096;
+
+    // Identifica l'istanza per le cache per thread di intern()
+    const std::uint64_t instanceId;
+    mutable std::shared_mutex m;
+    std::unordered_map<std::string_view, std::uint32_t, KeyHash, std::equal_to<>> codes;
+    std::deque<std::string> storage;
+    std::vector<std::unique_ptr<std::string_view[]>> ownedChunks;
+    std::array<std::atomic<std::string_view*>, kMaxChunks> chunks{};
+    std::atomic<std::uint32_t> count{0};
+
+    std::uint32_t internShared(std::string_view s);
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_STRING_DICTIONARY_H
@@ -9,50 +9,83 @@
 #include <format>
 #include <utility>
 #include<algorithm>
+#include "Money.h"
+#include "String_Dictionary.h"
 
 using Clock = std::chrono::system_clock;
 using TimePoint = Clock::time_point;
 
+// Tipo della transazione come tag: niente dispatch virtuale né stringhe sul percorso caldo
+enum class TransactionKind : std::uint8_t { Income, Expense };
+
+// Valore con segno (le uscite sono negative), risolto a compile time se il tipo è noto
+template <TransactionKind K>
+constexpr Money signedValue(Money amount) {
+    if constexpr (K == TransactionKind::Expense) return -amount;
+    else                                         return amount;
+}
+constexpr Money signedValue(TransactionKind kind, Money amount) {
+    return kind == TransactionKind::Expense ? signedValue<TransactionKind::Expense>(amount)
+                                            : signedValue<TransactionKind::Income>(amount);
+}
+
 class Transaction
 {
 protected:
+    TransactionKind tag;
     std::string id;
     TimePoint data;
-    double amount;
+    Money amount;
     std::string description;
-    std::string category;
-    std::string OperationType;
-    std::string SenderAccount;
-    std::string ReceiverAccount;
+    // Campi a bassa cardinalità: codici di StringDictionary::shared()
+    std::uint32_t category;
+    std::uint32_t OperationType;
+    std::uint32_t SenderAccount;
+    std::uint32_t ReceiverAccount;
 
 
 public:
-    Transaction(std::string idGen, TimePoint d, double i, std::string desc, std::string cat,
+    Transaction(TransactionKind k, std::string idGen, TimePoint d, Money i, std::string desc, std::string cat,
                 std::string Optype, std::string sendAcc, std::string recAcc)
-        : id(std::move(idGen)), data(d), amount(i), description(std::move(desc)), category(std::move(cat)),
-          OperationType(std::move(Optype)), SenderAccount(std::move(sendAcc)), ReceiverAccount(std::move(recAcc)) {}
+        : tag(k), id(std::move(idGen)), data(d), amount(i), description(std::move(desc)),
+          category(StringDictionary::shared().intern(cat)),
+          OperationType(StringDictionary::shared().intern(Optype)),
+          SenderAccount(StringDictionary::shared().intern(sendAcc)),
+          ReceiverAccount(StringDictionary::shared().intern(recAcc)) {}
 
     virtual ~Transaction() = default;
 
-    const std::string getId() const{
+    const std::string& getId() const{
         return id;
     }
-    const std::string getSenderAccount() const{
+    std::string_view getSenderAccount() const{
+        return StringDictionary::shared()[SenderAccount];
+    }
+    std::string_view getReceiverAccount() const{
+        return StringDictionary::shared()[ReceiverAccount];
+    }
+    std::string_view getCategory() const{
+        return StringDictionary::shared()[category];
+    }
+    const std::string& getDescription() const{
+        return description;
+    }
+    std::string_view getOperationType() const{
+        return StringDictionary::shared()[OperationType];
+    }
+    std::uint32_t getSenderCode() const{
         return SenderAccount;
     }
-    const std::string getReceiverAccount() const{
+    std::uint32_t getReceiverCode() const{
         return ReceiverAccount;
     }
-    const std::string getCategory() const{
+    std::uint32_t getCategoryCode() const{
         return category;
     }
-    const std::string getDescription() const{
-        return description;
-    }
-    const std::string getOperationType() const{
+    std::uint32_t getOperationTypeCode() const{
         return OperationType;
     }
-    double getAmount() const{
+    Money getAmount() const{
         return amount;
     }
     TimePoint getData() const{
@@ -63,11 +96,21 @@ public:
         return std::format("{:%Y-%m-%d %H:%M:%S}", data);
     }
 
+    // Percorso non virtuale usato da BankAccount e dallo store
+    TransactionKind kind() const{
+        return tag;
+    }
+    Money value() const{
+        return signedValue(tag, amount);
+    }
+
+    // API polimorfica storica, mantenuta per compatibilità
     virtual std::string getType() const = 0;
-    virtual double getValue() const = 0;
+    virtual Money getValue() const = 0;
     virtual std::string toCSV() const {
-        return std::format("{},{},{},{},{},{},{},{}", id, getDataFormatted(), amount,
-                           description, category, OperationType, SenderAccount, ReceiverAccount);
+        return std::format("{},{},{},{},{},{},{},{}", id, getDataFormatted(), amount.toString(),
+                           description, getCategory(), getOperationType(), getSenderAccount(),
+                           getReceiverAccount());
     }
 };
 
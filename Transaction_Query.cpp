@@ -0,0 +1,213 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#include <algorithm>
+#include <format>
+#include "Transaction_Query.h"
+
+static bool isDictionaryField(QueryField field) {
+    return field != QueryField::Id && field != QueryField::Description;
+}
+
+static std::uint32_t codeAt(const TransactionStore& store, QueryField field, std::uint32_t row) {
+    switch (field) {
+        case QueryField::Category:      return store.categoryCodes()[row];
+        case QueryField::OperationType: return store.operationTypeCodes()[row];
+        case QueryField::Receiver:      return store.receiverCodes()[row];
+        default:                        return store.senderCodes()[row];
+    }
+}
+
+std::string QueryExplain::toString() const {
+    return std::format("{}: candidates={} examined={} matched={} returned={}",
+                       access, candidates, examined, matched, returned);
+}
+
+TransactionQuery::Matcher TransactionQuery::matcher() const {
+    const StringDictionary& dictionary = StringDictionary::shared();
+    Matcher m;
+    for (const Condition& c : conditions) {
+        if (!isDictionaryField(c.field)) {
+            m.texts.push_back(Matcher::TextTest{c.field, c.value, c.prefix});
+            continue;
+        }
+        Matcher::CodeTest test{c.field, 0, {}, {}};
+        if (c.prefix) {
+            test.prefix = c.value;
+        } else if (const auto code = dictionary.find(c.value)) {
+            test.code = *code;
+        } else {
+            // Una stringa mai vista dal dizionario non compare in nessuna riga
+            m.impossible = true;
+        }
+        m.codes.push_back(std::move(test));
+    }
+    m.from = fromTime;
+    m.to = toTime;
+    m.minAmount = minAmountBound;
+    m.maxAmount = maxAmountBound;
+    return m;
+}
+
+bool TransactionQuery::Matcher::CodeTest::accepts(std::uint32_t candidate) const {
+    if (!prefix) return candidate == code;
+    // Il dizionario è condiviso e molto più grande dei codici di un conto: niente
+    // tabella sull'intero dizionario, solo i codici effettivamente incontrati
+    const auto [it, inserted] = verdicts.try_emplace(candidate, false);
+    if (inserted) it->second = StringDictionary::shared()[candidate].starts_with(*prefix);
+    return it->second;
+}
+
+bool TransactionQuery::Matcher::operator()(const TransactionStore& store, std::uint32_t row) const {
+    if (impossible) return false;
+    if (from || to) {
+        const TimePoint ts = store.timestamps()[row];
+        if ((from && ts < *from) || (to && ts >= *to)) return false;
+    }
+    const Money amount = store.amounts()[row];
+    if ((minAmount && amount < *minAmount) || (maxAmount && amount > *maxAmount)) return false;
+
+    for (const CodeTest& test : codes) {
+        if (test.field == QueryField::Counterparty) {
+            if (!test.accepts(store.senderCodes()[row]) && !test.accepts(store.receiverCodes()[row])) return false;
+        } else if (!test.accepts(codeAt(store, test.field, row))) {
+            return false;
+        }
+    }
+    for (const TextTest& test : texts) {
+        const std::string_view value = test.field == QueryField::Id ? store.id(row) : store.description(row);
+        if (test.prefix ? !value.starts_with(test.value) : value != test.value) return false;
+    }
+    return true;
+}
+
+std::span<const std::uint32_t> TransactionQuery::window(const TransactionStore& store) const {
+    if (!fromTime && !toTime) return store.rowsByTime();
+    return store.rowsBetween(fromTime.value_or(TimePoint::min()), toTime.value_or(TimePoint::max()));
+}
+
+TransactionQuery::Access TransactionQuery::plan(const TransactionStore& store) const {
+    // Di base: finestra temporale (ricerca binaria), già in ordine
+    Access best;
+    best.rows = window(store);
+    best.timeOrdered = true;
+    best.label = fromTime || toTime ? "time range" : "full scan";
+
+    // Le posting list hanno la dimensione esatta: vince quella più corta
+    for (const Condition& c : conditions) {
+        if (c.prefix) continue;
+        if (c.field == QueryField::Id) {
+            Access byId;
+            byId.label = std::format("id '{}'", c.value);
+            byId.single = store.findId(c.value).transform([](std::size_t row) {
+                return static_cast<std::uint32_t>(row);
+            });
+            return byId;
+        }
+        if (!store.hasSecondaryIndexes()) continue;
+
+        Access byIndex;
+        if (c.field == QueryField::OperationType) {
+            byIndex.rows = store.rowsWithOperationType(c.value);
+            byIndex.label = std::format("index type='{}'", c.value);
+        } else if (c.field == QueryField::Counterparty || c.field == QueryField::Sender ||
+                   c.field == QueryField::Receiver) {
+            // L'indice copre mittente e destinatario: superset, il resto lo filtra il matcher
+            byIndex.rows = store.rowsWithCounterparty(c.value);
+            byIndex.label = std::format("index counterparty='{}'", c.value);
+        } else {
+            continue;
+        }
+        if (byIndex.rows.size() < best.rows.size()) best = byIndex;
+    }
+    return best;
+}
+
+QueryExplain TransactionQuery::run(const TransactionStore& store,
+                                   const std::function<void(std::uint32_t)>& emit) const {
+    const Access access = plan(store);
+    std::span<const std::uint32_t> rows = access.rows;
+    std::uint32_t singleRow = 0;
+    if (access.single) {
+        singleRow = *access.single;
+        rows = {&singleRow, 1};
+    }
+
+    QueryExplain stats;
+    stats.access = access.label;
+    stats.candidates = rows.size();
+    if (limitRows == 0) return stats;
+    const Matcher match = matcher();
+    const auto timestamps = store.timestamps();
+    const auto amounts = store.amounts();
+
+    // Ordine temporale su candidati già ordinati: streaming, stop al limite
+    const bool byTime = ordering == QueryOrder::Oldest || ordering == QueryOrder::Newest;
+    if (byTime && access.timeOrdered) {
+        const bool newest = ordering == QueryOrder::Newest;
+        const std::size_t n = rows.size();
+        for (std::size_t i = 0; i < n && stats.returned < limitRows; ++i) {
+            const std::uint32_t row = rows[newest ? n - 1 - i : i];
+            ++stats.examined;
+            if (!match(store, row)) continue;
+            if (++stats.matched <= skipRows) continue;
+            emit(row);
+            ++stats.returned;
+        }
+        return stats;
+    }
+
+    // Altrimenti le migliori offset + limit in un heap: in cima la peggiore.
+    // A parità di chiave vale l'ordine temporale dello store (timestamp, riga).
+    const auto earlier = [&](std::uint32_t a, std::uint32_t b) {
+        return timestamps[a] < timestamps[b] || (timestamps[a] == timestamps[b] && a < b);
+    };
+    const auto better = [&](std::uint32_t a, std::uint32_t b) {
+        switch (ordering) {
+            case QueryOrder::Oldest: return earlier(a, b);
+            case QueryOrder::Newest: return earlier(b, a);
+            case QueryOrder::LargestAmount:
+                if (amounts[a] != amounts[b]) return amounts[a] > amounts[b];
+                return earlier(a, b);
+            case QueryOrder::SmallestAmount:
+                if (amounts[a] != amounts[b]) return amounts[a] < amounts[b];
+                return earlier(a, b);
+        }
+        return false;
+    };
+    const std::size_t k = limitRows > SIZE_MAX - skipRows ? SIZE_MAX : skipRows + limitRows;
+    std::vector<std::uint32_t> best;
+    for (const std::uint32_t row : rows) {
+        ++stats.examined;
+        if (!match(store, row)) continue;
+        ++stats.matched;
+        if (best.size() < k) {
+            best.push_back(row);
+            std::ranges::push_heap(best, better);
+        } else if (better(row, best.front())) {
+            std::ranges::pop_heap(best, better);
+            best.back() = row;
+            std::ranges::push_heap(best, better);
+        }
+    }
+    std::ranges::sort_heap(best, better);
+    for (std::size_t i = skipRows; i < best.size(); ++i) {
+        emit(best[i]);
+        ++stats.returned;
+    }
+    return stats;
+}
+
+std::vector<TransactionView> TransactionQuery::collect(const TransactionStore& store) const {
+    std::vector<TransactionView> out;
+    // Senza limite il numero di risultati non si conosce: riservare store.size() costerebbe
+    // memoria proporzionale a tutto il conto anche per una query selettiva
+    if (limitRows != SIZE_MAX) out.reserve(std::min(limitRows, store.size()));
+    forEach(store, [&](const TransactionView& t) { out.push_back(t); });
+    return out;
+}
+
+QueryExplain TransactionQuery::explain(const TransactionStore& store) const {
+    return run(store, [](std::uint32_t) {});
+}
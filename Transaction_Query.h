@@ -0,0 +1,195 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_TRANSACTION_QUERY_H
+#define FINANCIAL_TRANSACTIONS_TRANSACTION_QUERY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Transaction_Store.h"
+
+enum class QueryOrder { Oldest, Newest, LargestAmount, SmallestAmount };
+
+// Campi testuali interrogabili; Counterparty = mittente o destinatario
+enum class QueryField { Id, Description, Category, OperationType, Sender, Receiver, Counterparty };
+
+// Piano scelto e lavoro svolto da un'esecuzione (vedi TransactionQuery::explain)
+struct QueryExplain {
+    std::string access;          // es. "index type='Expense'", "time range", "full scan"
+    std::size_t candidates = 0;  // righe fornite dal percorso di accesso
+    std::size_t examined = 0;    // righe su cui sono state valutate le condizioni
+    std::size_t matched = 0;     // righe che le soddisfano tutte
+    std::size_t returned = 0;    // dopo offset e limit
+
+    std::string toString() const;
+};
+
+// Interrogazione componibile: congiunzione di condizioni di uguaglianza, prefisso e
+// intervallo sui campi delle transazioni, più ordinamento, offset e limit.
+//   TransactionQuery().category("Groceries").newestFirst().limit(50)
+// forEach/collect passano da un pianificatore: fra ID, indice per tipo, indice per
+// controparte e intervallo di date sceglie il percorso con meno righe candidate e
+// valuta le altre condizioni solo su quelle. In ordine temporale la scansione si ferma
+// dopo offset + limit corrispondenze; negli altri casi si tengono solo le migliori
+// offset + limit (selezione parziale, niente sort completo).
+class TransactionQuery {
+public:
+    // Uguaglianza e prefisso su un campo testuale (più condizioni si sommano in AND)
+    TransactionQuery& where(QueryField field, std::string_view value) {
+        conditions.push_back(Condition{field, std::string(value), false});
+        return *this;
+    }
+    TransactionQuery& wherePrefix(QueryField field, std::string_view prefix) {
+        conditions.push_back(Condition{field, std::string(prefix), true});
+        return *this;
+    }
+    TransactionQuery& id(std::string_view txId) {
+        return where(QueryField::Id, txId);
+    }
+    TransactionQuery& type(std::string_view opType) {
+        return where(QueryField::OperationType, opType);
+    }
+    TransactionQuery& counterparty(std::string_view accountId) {
+        return where(QueryField::Counterparty, accountId);
+    }
+    TransactionQuery& category(std::string_view cat) {
+        return where(QueryField::Category, cat);
+    }
+    // Data in [from, to)
+    TransactionQuery& between(TimePoint from, TimePoint to) {
+        fromTime = from;
+        toTime = to;
+        return *this;
+    }
+    // Limiti inclusivi sull'importo (sempre positivo, qualunque sia il tipo)
+    TransactionQuery& minAmount(Money m) {
+        minAmountBound = m;
+        return *this;
+    }
+    TransactionQuery& maxAmount(Money m) {
+        maxAmountBound = m;
+        return *this;
+    }
+    TransactionQuery& offset(std::size_t n) {
+        skipRows = n;
+        return *this;
+    }
+    TransactionQuery& limit(std::size_t n) {
+        limitRows = n;
+        return *this;
+    }
+    TransactionQuery& orderBy(QueryOrder o) {
+        ordering = o;
+        return *this;
+    }
+    TransactionQuery& newestFirst() {
+        return orderBy(QueryOrder::Newest);
+    }
+
+    QueryOrder order() const {
+        return ordering;
+    }
+
+    // Vista lazy in ordine temporale (Oldest/Newest) sulla finestra di date, con offset
+    // e limit già applicati: non usa gli indici, ma non materializza nulla.
+    // Punta nello store: da usare finché non cambia. Per l'ordine per importo lancia
+    // std::runtime_error (serve forEach o collect).
+    auto rows(const TransactionStore& store) const {
+        if (ordering != QueryOrder::Oldest && ordering != QueryOrder::Newest) {
+            throw std::runtime_error("Amount ordering needs forEach/collect");
+        }
+        const std::span<const std::uint32_t> candidates = window(store);
+        const std::size_t n = candidates.size();
+        const bool newest = ordering == QueryOrder::Newest;
+        return std::views::iota(std::size_t{0}, n)
+             | std::views::transform([candidates, n, newest](std::size_t i) {
+                   return candidates[newest ? n - 1 - i : i];
+               })
+             | std::views::filter([&store, match = matcher()](std::uint32_t row) {
+                   return match(store, row);
+               })
+             | std::views::drop(static_cast<std::ptrdiff_t>(std::min<std::size_t>(skipRows, PTRDIFF_MAX)))
+             | std::views::take(static_cast<std::ptrdiff_t>(std::min<std::size_t>(limitRows, PTRDIFF_MAX)));
+    }
+
+    // Esegue il piano e passa ogni risultato a f(TransactionView); restituisce quanti sono
+    template <class F>
+    std::size_t forEach(const TransactionStore& store, F&& f) const {
+        return run(store, [&](std::uint32_t row) { f(store[row]); }).returned;
+    }
+    std::vector<TransactionView> collect(const TransactionStore& store) const;
+    // Esegue il piano senza produrre risultati e riporta percorso e righe esaminate
+    QueryExplain explain(const TransactionStore& store) const;
+
+private:
+    struct Condition {
+        QueryField field;
+        std::string value;
+        bool prefix;
+    };
+
+    // Condizioni risolte: i campi del dizionario diventano un codice (uguaglianza) o un
+    // prefisso valutato una volta per codice incontrato, quindi il confronto per riga è fra interi
+    struct Matcher {
+        struct CodeTest {
+            QueryField field;
+            std::uint32_t code;
+            std::optional<std::string> prefix;
+            // Esito del prefisso per i soli codici visti nelle righe esaminate
+            mutable std::unordered_map<std::uint32_t, bool> verdicts;
+
+            bool accepts(std::uint32_t candidate) const;
+        };
+        struct TextTest {
+            QueryField field;
+            std::string value;
+            bool prefix;
+        };
+
+        bool impossible = false;
+        std::vector<CodeTest> codes;
+        std::vector<TextTest> texts;
+        std::optional<TimePoint> from;
+        std::optional<TimePoint> to;
+        std::optional<Money> minAmount;
+        std::optional<Money> maxAmount;
+
+        bool operator()(const TransactionStore& store, std::uint32_t row) const;
+    };
+
+    // Percorso di accesso scelto dal pianificatore
+    struct Access {
+        std::string label;
+        std::span<const std::uint32_t> rows;
+        std::optional<std::uint32_t> single;  // ricerca per ID: al più una riga
+        bool timeOrdered = false;             // rows è già in ordine temporale
+    };
+
+    std::vector<Condition> conditions;
+    std::optional<TimePoint> fromTime;
+    std::optional<TimePoint> toTime;
+    std::optional<Money> minAmountBound;
+    std::optional<Money> maxAmountBound;
+    std::size_t skipRows = 0;
+    std::size_t limitRows = SIZE_MAX;
+    QueryOrder ordering = QueryOrder::Oldest;
+
+    Matcher matcher() const;
+    std::span<const std::uint32_t> window(const TransactionStore& store) const;
+    Access plan(const TransactionStore& store) const;
+    QueryExplain run(const TransactionStore& store, const std::function<void(std::uint32_t)>& emit) const;
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_TRANSACTION_QUERY_H
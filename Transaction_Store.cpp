@@ -0,0 +1,211 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#include <algorithm>
+#include <stdexcept>
+#include "Transaction_Store.h"
+
+TransactionStore::TransactionStore(std::pmr::memory_resource* mr)
+    : amountCol(mr), dataCol(mr), kindCol(mr), idCol(mr), descriptionCol(mr),
+      categoryCol(mr), operationTypeCol(mr), senderCol(mr), receiverCol(mr),
+      idIndex(mr), typeIndex(mr), counterpartyIndex(mr), timeOrder(mr) {}
+
+std::size_t TransactionStore::append(const TransactionRecord& r) {
+    return append(r, intern(r));
+}
+
+std::size_t TransactionStore::append(const TransactionRecord& r, const FieldCodes& codes) {
+    const std::size_t row = appendColumns(r, codes);
+    placeInTimeOrder(row);
+    return row;
+}
+
+TransactionStore::FieldCodes TransactionStore::intern(const TransactionRecord& r) {
+    StringDictionary& dictionary = StringDictionary::shared();
+    return FieldCodes{dictionary.intern(r.category), dictionary.intern(r.operationType),
+                      dictionary.intern(r.senderAccount), dictionary.intern(r.receiverAccount)};
+}
+
+std::size_t TransactionStore::appendColumns(const TransactionRecord& r, const FieldCodes& codes) {
+    const std::size_t row = size();
+    // L'indice confronta solo righe già presenti: si può inserire prima delle colonne
+    if (!idIndex.insert(r.id, row, idCol)) {
+        throw std::runtime_error("Duplicate transaction ID: " + std::string(r.id));
+    }
+    amountCol.push_back(r.amount);
+    dataCol.push_back(r.data);
+    kindCol.push_back(r.kind);
+    idCol.push_back(r.id);
+    descriptionCol.push_back(r.description);
+    categoryCol.push_back(codes.category);
+    operationTypeCol.push_back(codes.operationType);
+    senderCol.push_back(codes.sender);
+    receiverCol.push_back(codes.receiver);
+    if (secondaryIndexes) indexSecondary(row);
+    return row;
+}
+
+void TransactionStore::placeInTimeOrder(std::size_t row) {
+    const bool inOrder = sortedRows == timeOrder.size() &&
+                         (timeOrder.empty() || dataCol[timeOrder.back()] <= dataCol[row]);
+    timeOrder.push_back(static_cast<std::uint32_t>(row));
+    if (inOrder) {
+        ++sortedRows;
+    } else {
+        // Arrivo in ritardo: resta in coda finché qualcuno non legge l'ordine temporale
+        lateRows.store(true, std::memory_order_relaxed);
+    }
+}
+
+void TransactionStore::mergeTimeOrder(std::size_t firstNewRow) {
+    for (std::size_t row = firstNewRow; row < size(); ++row) {
+        timeOrder.push_back(static_cast<std::uint32_t>(row));
+    }
+    // I ritardatari ancora in coda si fondono insieme al blocco
+    lateRows.store(true, std::memory_order_relaxed);
+    settleTimeOrder();
+}
+
+void TransactionStore::settleTimeOrder() const {
+    if (!lateRows.load(std::memory_order_acquire)) return;
+    std::lock_guard lock(settleMutex);
+    if (!lateRows.load(std::memory_order_relaxed)) return;
+    const auto mid = timeOrder.begin() + static_cast<std::ptrdiff_t>(sortedRows);
+    const auto byTime = [&](std::uint32_t a, std::uint32_t b) {
+        return dataCol[a] < dataCol[b] || (dataCol[a] == dataCol[b] && a < b);
+    };
+    if (!std::is_sorted(mid, timeOrder.end(), byTime)) {
+        std::sort(mid, timeOrder.end(), byTime);
+    }
+    if (mid != timeOrder.begin() && mid != timeOrder.end() && byTime(*mid, *(mid - 1))) {
+        std::inplace_merge(timeOrder.begin(), mid, timeOrder.end(), byTime);
+    }
+    sortedRows = timeOrder.size();
+    lateRows.store(false, std::memory_order_release);
+}
+
+void TransactionStore::appendBatch(std::span<const TransactionRecord> batch) {
+    appendBatch(batch, {});
+}
+
+void TransactionStore::appendBatch(std::span<const TransactionRecord> batch, std::span<const FieldCodes> codes) {
+    const std::size_t firstNewRow = size();
+    // Crescita geometrica: una sequenza di blocchi piccoli non rialloca le colonne a ogni blocco
+    const std::size_t needed = firstNewRow + batch.size();
+    if (needed > amountCol.capacity()) reserve(std::max(needed, 2 * amountCol.capacity()));
+    // Le righe entrano nelle colonne una alla volta, l'ordine temporale si fonde alla fine
+    try {
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            appendColumns(batch[i], codes.empty() ? intern(batch[i]) : codes[i]);
+        }
+    } catch (...) {
+        truncate(firstNewRow);
+        throw;
+    }
+    mergeTimeOrder(firstNewRow);
+}
+
+void TransactionStore::truncate(std::size_t rows) {
+    if (rows >= size()) return;
+    for (std::size_t row = size(); row-- > rows;) {
+        idIndex.erase(idCol[row], row);
+    }
+    typeIndex.truncate(rows);
+    counterpartyIndex.truncate(rows);
+    // Sulla sequenza già fusa la rimozione conserva l'ordine
+    settleTimeOrder();
+    std::erase_if(timeOrder, [&](std::uint32_t row) { return row >= rows; });
+    sortedRows = timeOrder.size();
+    amountCol.resize(rows);
+    dataCol.resize(rows);
+    kindCol.resize(rows);
+    idCol.truncate(rows);
+    descriptionCol.truncate(rows);
+    categoryCol.resize(rows);
+    operationTypeCol.resize(rows);
+    senderCol.resize(rows);
+    receiverCol.resize(rows);
+}
+
+std::span<const std::uint32_t> TransactionStore::rowsBetween(TimePoint from, TimePoint to) const {
+    if (to <= from) return {};
+    settleTimeOrder();
+    const auto first = std::lower_bound(timeOrder.begin(), timeOrder.end(), from,
+        [&](std::uint32_t r, TimePoint value) { return dataCol[r] < value; });
+    const auto last = std::lower_bound(first, timeOrder.end(), to,
+        [&](std::uint32_t r, TimePoint value) { return dataCol[r] < value; });
+    return {first, last};
+}
+
+void TransactionStore::indexSecondary(std::size_t row) {
+    typeIndex.add(operationTypeCol[row], row);
+    const std::uint32_t sender = senderCol[row];
+    const std::uint32_t receiver = receiverCol[row];
+    counterpartyIndex.add(sender, row);
+    if (receiver != sender) counterpartyIndex.add(receiver, row);
+}
+
+void TransactionStore::setSecondaryIndexes(bool enabled) {
+    typeIndex.clear();
+    counterpartyIndex.clear();
+    secondaryIndexes = enabled;
+    if (!enabled) return;
+    for (std::size_t row = 0; row < size(); ++row) {
+        indexSecondary(row);
+    }
+}
+
+std::size_t TransactionStore::append(const Transaction& t) {
+    // Nessuna copia né chiamata virtuale: tag e codici del dizionario presi così come sono
+    const TransactionRecord r{
+        t.getId(), t.getData(), t.getAmount(), t.kind(),
+        t.getDescription(), t.getCategory(), t.getOperationType(), t.getSenderAccount(), t.getReceiverAccount()};
+    const std::size_t row = appendColumns(r, FieldCodes{t.getCategoryCode(), t.getOperationTypeCode(),
+                                                        t.getSenderCode(), t.getReceiverCode()});
+    placeInTimeOrder(row);
+    return row;
+}
+
+void TransactionStore::reserve(std::size_t rows) {
+    amountCol.reserve(rows);
+    dataCol.reserve(rows);
+    kindCol.reserve(rows);
+    idCol.reserve(rows, 0);
+    descriptionCol.reserve(rows, 0);
+    categoryCol.reserve(rows);
+    operationTypeCol.reserve(rows);
+    senderCol.reserve(rows);
+    receiverCol.reserve(rows);
+    idIndex.reserve(rows);
+    timeOrder.reserve(rows);
+}
+
+void TransactionStore::clear() {
+    amountCol.clear();
+    dataCol.clear();
+    kindCol.clear();
+    idCol.clear();
+    descriptionCol.clear();
+    categoryCol.clear();
+    operationTypeCol.clear();
+    senderCol.clear();
+    receiverCol.clear();
+    idIndex.clear();
+    typeIndex.clear();
+    counterpartyIndex.clear();
+    timeOrder.clear();
+    sortedRows = 0;
+    lateRows.store(false, std::memory_order_relaxed);
+}
+
+std::size_t TransactionStore::memoryFootprint() const {
+    const std::size_t rows = size();
+    // Ordine temporale + 4 colonne di codici (il dizionario è condiviso e non conta)
+    std::size_t bytes = rows * (sizeof(Money) + sizeof(TimePoint) + sizeof(TransactionKind)
+                                + 5 * sizeof(std::uint32_t));
+    for (const StringColumn* col : {&idCol, &descriptionCol}) {
+        bytes += col->byteSize() + rows * sizeof(std::uint64_t);
+    }
+    return bytes;
+}
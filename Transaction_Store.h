@@ -0,0 +1,357 @@
+//
+// Created by Andrea Peli on 16/10/26.
+//
+
+#ifndef FINANCIAL_TRANSACTIONS_TRANSACTION_STORE_H
+#define FINANCIAL_TRANSACTIONS_TRANSACTION_STORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Transaction.h"
+#include "Id_Index.h"
+#include "Posting_Index.h"
+#include "String_Dictionary.h"
+
+// Riga in ingresso allo store: i campi testuali vengono copiati nelle colonne
+struct TransactionRecord {
+    std::string_view id;
+    TimePoint data;
+    Money amount{};
+    TransactionKind kind{TransactionKind::Income};
+    std::string_view description;
+    std::string_view category;
+    std::string_view operationType;
+    std::string_view senderAccount;
+    std::string_view receiverAccount;
+
+    Money value() const {
+        return signedValue(kind, amount);
+    }
+};
+
+// Colonna di stringhe: un unico buffer contiguo + offset di fine per riga
+class StringColumn {
+private:
+    std::pmr::string bytes;
+    std::pmr::vector<std::uint64_t> ends;
+
+public:
+    explicit StringColumn(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : bytes(mr), ends(mr) {}
+
+    void push_back(std::string_view s) {
+        bytes.append(s);
+        ends.push_back(bytes.size());
+    }
+    std::string_view operator[](std::size_t row) const {
+        const std::uint64_t begin = row == 0 ? 0 : ends[row - 1];
+        return std::string_view(bytes).substr(begin, ends[row] - begin);
+    }
+    std::size_t size() const {
+        return ends.size();
+    }
+    std::size_t byteSize() const {
+        return bytes.size();
+    }
+    // Tiene solo le prime rows righe
+    void truncate(std::size_t rows) {
+        if (rows >= ends.size()) return;
+        bytes.resize(rows == 0 ? 0 : ends[rows - 1]);
+        ends.resize(rows);
+    }
+    void reserve(std::size_t rows, std::size_t chars) {
+        ends.reserve(rows);
+        bytes.reserve(chars);
+    }
+    void clear() {
+        bytes.clear();
+        ends.clear();
+    }
+};
+
+class TransactionStore;
+
+// Vista leggera su una riga dello store: stessi accessor di Transaction.
+// Resta valida finché lo store non viene svuotato.
+class TransactionView {
+private:
+    const TransactionStore* store;
+    std::size_t index;
+
+public:
+    TransactionView(const TransactionStore& s, std::size_t row) : store(&s), index(row) {}
+
+    std::size_t row() const {
+        return index;
+    }
+    std::string_view getId() const;
+    std::string_view getSenderAccount() const;
+    std::string_view getReceiverAccount() const;
+    std::string_view getCategory() const;
+    std::string_view getDescription() const;
+    std::string_view getOperationType() const;
+    Money getAmount() const;
+    TimePoint getData() const;
+    TransactionKind getKind() const;
+    std::uint32_t getCategoryCode() const;
+
+    std::string getDataFormatted() const {
+        return std::format("{:%Y-%m-%d %H:%M:%S}", getData());
+    }
+    std::string_view getType() const {
+        return getKind() == TransactionKind::Expense ? "Expense" : "Income";
+    }
+    Money getValue() const {
+        return signedValue(getKind(), getAmount());
+    }
+    // Campi della riga (le string_view puntano nello store)
+    TransactionRecord record() const {
+        return TransactionRecord{getId(), getData(), getAmount(), getKind(), getDescription(),
+                                 getCategory(), getOperationType(), getSenderAccount(), getReceiverAccount()};
+    }
+};
+
+// Storage colonnare: importi, timestamp e tipo in array contigui,
+// colonne testuali separate (lette solo quando servono).
+// Categoria, tipo di operazione e conti sono codici di StringDictionary::shared().
+class TransactionStore {
+public:
+    // Codici di StringDictionary::shared() dei campi a bassa cardinalità di un record
+    struct FieldCodes {
+        std::uint32_t category;
+        std::uint32_t operationType;
+        std::uint32_t sender;
+        std::uint32_t receiver;
+    };
+
+private:
+    std::pmr::vector<Money> amountCol;
+    std::pmr::vector<TimePoint> dataCol;
+    std::pmr::vector<TransactionKind> kindCol;
+    StringColumn idCol;
+    StringColumn descriptionCol;
+    std::pmr::vector<std::uint32_t> categoryCol;
+    std::pmr::vector<std::uint32_t> operationTypeCol;
+    std::pmr::vector<std::uint32_t> senderCol;
+    std::pmr::vector<std::uint32_t> receiverCol;
+    IdIndex idIndex;
+    // Indici secondari opzionali: tipo di operazione e conto controparte
+    bool secondaryIndexes = true;
+    PostingIndex typeIndex;
+    PostingIndex counterpartyIndex;
+    // Righe ordinate per (timestamp, riga): append in coda se in ordine. I ritardatari
+    // restano in coda oltre sortedRows e si fondono tutti insieme (sort + merge) al
+    // prossimo blocco o alla prima lettura ordinata: niente insert a metà vettore per riga
+    mutable std::pmr::vector<std::uint32_t> timeOrder;
+    mutable std::size_t sortedRows = 0;
+    mutable std::atomic<bool> lateRows = false;
+    // Più lettori (lock condiviso del conto) possono trovare la coda da fondere
+    mutable std::mutex settleMutex;
+
+    std::size_t appendColumns(const TransactionRecord& r, const FieldCodes& codes);
+    void indexSecondary(std::size_t row);
+    void placeInTimeOrder(std::size_t row);
+    void mergeTimeOrder(std::size_t firstNewRow);
+    void settleTimeOrder() const;
+
+public:
+    static FieldCodes intern(const TransactionRecord& r);
+
+    // Tutte le colonne e gli indici allocano da mr (es. un'arena monotona per conto:
+    // distruggere lo store e poi l'arena libera la storia in blocco)
+    explicit TransactionStore(std::pmr::memory_resource* mr = std::pmr::get_default_resource());
+
+    std::pmr::memory_resource* resource() const {
+        return amountCol.get_allocator().resource();
+    }
+
+    // Lancia std::runtime_error se l'ID è già presente (lo store resta invariato)
+    std::size_t append(const TransactionRecord& r);
+    std::size_t append(const Transaction& t);
+    // Con i codici già calcolati da intern() (es. per validare la riga prima di inserirla)
+    std::size_t append(const TransactionRecord& r, const FieldCodes& codes);
+    // Inserimento in blocco, tutto o niente: le righe fuori ordine vengono ordinate e fuse
+    // in un solo passaggio; se una riga fallisce (es. ID duplicato) lo store torna com'era
+    void appendBatch(std::span<const TransactionRecord> batch);
+    // codes[i] = intern(batch[i]); vuoto: calcolati qui
+    void appendBatch(std::span<const TransactionRecord> batch, std::span<const FieldCodes> codes);
+    // Rimuove le righe da rows in poi (colonne e indici)
+    void truncate(std::size_t rows);
+    void reserve(std::size_t rows);
+    void clear();
+
+    // Abilitandoli vengono ricostruiti sulle righe presenti
+    void setSecondaryIndexes(bool enabled);
+    bool hasSecondaryIndexes() const {
+        return secondaryIndexes;
+    }
+    std::span<const std::uint32_t> rowsWithOperationType(std::uint32_t opTypeCode) const {
+        return typeIndex.find(opTypeCode);
+    }
+    std::span<const std::uint32_t> rowsWithOperationType(std::string_view opType) const {
+        const auto code = StringDictionary::shared().find(opType);
+        return code ? typeIndex.find(*code) : std::span<const std::uint32_t>{};
+    }
+    // Righe in cui il conto compare come mittente o destinatario (una volta sola)
+    std::span<const std::uint32_t> rowsWithCounterparty(std::uint32_t accountCode) const {
+        return counterpartyIndex.find(accountCode);
+    }
+    std::span<const std::uint32_t> rowsWithCounterparty(std::string_view accountId) const {
+        const auto code = StringDictionary::shared().find(accountId);
+        return code ? counterpartyIndex.find(*code) : std::span<const std::uint32_t>{};
+    }
+
+    std::size_t size() const {
+        return amountCol.size();
+    }
+    bool empty() const {
+        return amountCol.empty();
+    }
+    TransactionView operator[](std::size_t row) const {
+        return TransactionView(*this, row);
+    }
+
+    std::span<const Money> amounts() const {
+        return amountCol;
+    }
+    std::span<const TimePoint> timestamps() const {
+        return dataCol;
+    }
+    std::span<const TransactionKind> kinds() const {
+        return kindCol;
+    }
+    std::string_view id(std::size_t row) const {
+        return idCol[row];
+    }
+    std::optional<std::size_t> findId(std::string_view txId) const {
+        return idIndex.find(txId, idCol);
+    }
+    bool containsId(std::string_view txId) const {
+        return findId(txId).has_value();
+    }
+    std::string_view description(std::size_t row) const {
+        return descriptionCol[row];
+    }
+    std::string_view category(std::size_t row) const {
+        return StringDictionary::shared()[categoryCol[row]];
+    }
+    std::string_view operationType(std::size_t row) const {
+        return StringDictionary::shared()[operationTypeCol[row]];
+    }
+    std::string_view senderAccount(std::size_t row) const {
+        return StringDictionary::shared()[senderCol[row]];
+    }
+    std::string_view receiverAccount(std::size_t row) const {
+        return StringDictionary::shared()[receiverCol[row]];
+    }
+    std::span<const std::uint32_t> categoryCodes() const {
+        return categoryCol;
+    }
+    std::span<const std::uint32_t> operationTypeCodes() const {
+        return operationTypeCol;
+    }
+    std::span<const std::uint32_t> senderCodes() const {
+        return senderCol;
+    }
+    std::span<const std::uint32_t> receiverCodes() const {
+        return receiverCol;
+    }
+
+    std::span<const std::uint32_t> rowsByTime() const {
+        settleTimeOrder();
+        return timeOrder;
+    }
+    // Righe con timestamp in [from, to), in ordine temporale (ricerca binaria)
+    std::span<const std::uint32_t> rowsBetween(TimePoint from, TimePoint to) const;
+
+    // Byte occupati dalle colonne (escluse le capacità non usate)
+    std::size_t memoryFootprint() const;
+};
+
+inline std::string_view TransactionView::getId() const { return store->id(index); }
+inline std::string_view TransactionView::getSenderAccount() const { return store->senderAccount(index); }
+inline std::string_view TransactionView::getReceiverAccount() const { return store->receiverAccount(index); }
+inline std::string_view TransactionView::getCategory() const { return store->category(index); }
+inline std::string_view TransactionView::getDescription() const { return store->description(index); }
+inline std::string_view TransactionView::getOperationType() const { return store->operationType(index); }
+inline Money TransactionView::getAmount() const { return store->amounts()[index]; }
+inline TimePoint TransactionView::getData() const { return store->timestamps()[index]; }
+inline TransactionKind TransactionView::getKind() const { return store->kinds()[index]; }
+inline std::uint32_t TransactionView::getCategoryCode() const { return store->categoryCodes()[index]; }
+
+// Copia di una riga, indipendente dallo store: è ciò che restituiscono le query di
+// BankAccount fuori dal lock. I campi a dizionario restano codici (le stringhe di
+// StringDictionary::shared() non si spostano mai), id e descrizione sono copiati.
+class TransactionRow {
+private:
+    std::string id;
+    std::string description;
+    TimePoint data;
+    Money amount;
+    TransactionKind kind;
+    std::uint32_t category;
+    std::uint32_t operationType;
+    std::uint32_t sender;
+    std::uint32_t receiver;
+
+public:
+    TransactionRow(const TransactionStore& s, std::size_t row)
+        : id(s.id(row)), description(s.description(row)), data(s.timestamps()[row]), amount(s.amounts()[row]),
+          kind(s.kinds()[row]), category(s.categoryCodes()[row]), operationType(s.operationTypeCodes()[row]),
+          sender(s.senderCodes()[row]), receiver(s.receiverCodes()[row]) {}
+
+    std::string_view getId() const {
+        return id;
+    }
+    std::string_view getSenderAccount() const {
+        return StringDictionary::shared()[sender];
+    }
+    std::string_view getReceiverAccount() const {
+        return StringDictionary::shared()[receiver];
+    }
+    std::string_view getCategory() const {
+        return StringDictionary::shared()[category];
+    }
+    std::string_view getDescription() const {
+        return description;
+    }
+    std::string_view getOperationType() const {
+        return StringDictionary::shared()[operationType];
+    }
+    Money getAmount() const {
+        return amount;
+    }
+    TimePoint getData() const {
+        return data;
+    }
+    TransactionKind getKind() const {
+        return kind;
+    }
+    std::uint32_t getCategoryCode() const {
+        return category;
+    }
+
+    std::string getDataFormatted() const {
+        return std::format("{:%Y-%m-%d %H:%M:%S}", data);
+    }
+    std::string_view getType() const {
+        return kind == TransactionKind::Expense ? "Expense" : "Income";
+    }
+    Money getValue() const {
+        return signedValue(kind, amount);
+    }
+    // Le string_view puntano in questa riga
+    TransactionRecord record() const {
+        return TransactionRecord{getId(), data, amount, kind, getDescription(),
+                                 getCategory(), getOperationType(), getSenderAccount(), getReceiverAccount()};
+    }
+};
+
+
+#endif //FINANCIAL_TRANSACTIONS_TRANSACTION_STORE_H
@@ -0,0 +1,292 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+// Google Benchmark dei percorsi caldi di BankAccount, da 1K a 10M righe.
+// Contatori: items/s (righe prodotte o consumate), bytes/s solo dove passano byte
+// (SaveToFile/ReadFromFile: il file; AddTransaction: righe x dimensione media di una
+// riga nel CSV), allocs/op e alloc_bytes/op (operator new globale contato qui sotto).
+// Uso: bench_bank_account [--benchmark_filter=Save] [--benchmark_min_time=...]
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "Bank_Account.h"
+
+using namespace std::chrono;
+
+// --- Conteggio delle allocazioni ---
+
+static std::atomic<std::uint64_t> allocCount{0};
+static std::atomic<std::uint64_t> allocBytes{0};
+
+static void* countedAlloc(std::size_t size, std::size_t align) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    void* p = align > alignof(std::max_align_t)
+                  ? std::aligned_alloc(align, (size + align - 1) / align * align)
+                  : std::malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size) {
+    return countedAlloc(size, 0);
+}
+void* operator new(std::size_t size, std::align_val_t align) {
+    return countedAlloc(size, static_cast<std::size_t>(align));
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+// Allocazioni fra il costruttore e report(), mediate sulle iterazioni
+class AllocationCounter {
+private:
+    std::uint64_t count = allocCount.load();
+    std::uint64_t bytes = allocBytes.load();
+public:
+    void report(benchmark::State& state) const {
+        state.counters["allocs/op"] = benchmark::Counter(static_cast<double>(allocCount.load() - count),
+                                                         benchmark::Counter::kAvgIterations);
+        state.counters["alloc_bytes/op"] = benchmark::Counter(static_cast<double>(allocBytes.load() - bytes),
+                                                              benchmark::Counter::kAvgIterations);
+    }
+};
+
+// --- Dati sintetici deterministici ---
+
+const std::string kPwd = "bench";
+const TimePoint kStart = sys_days{year{2025} / 1 / 1};
+constexpr std::size_t kCounterparties = 256;
+const std::array<std::string_view, 8> kCategories{"Salary", "Rent", "Food", "Transport",
+                                                  "Utilities", "Health", "Leisure", "Shopping"};
+
+static const std::vector<std::string>& counterparties() {
+    static const std::vector<std::string> names = [] {
+        std::vector<std::string> v;
+        for (std::size_t i = 0; i < kCounterparties; ++i) v.push_back("IT60X0542811101" + std::to_string(100000 + i));
+        return v;
+    }();
+    return names;
+}
+
+// Riga i: un'entrata ogni quattro righe copre le tre uscite successive (saldo mai negativo)
+static TransactionRecord makeRecord(std::size_t i, std::string& id) {
+    id = "TX-" + std::to_string(i);
+    const bool income = i % 4 == 0;
+    const std::string_view other = counterparties()[(i * 2654435761u) % kCounterparties];
+    return TransactionRecord{id,
+                             kStart + seconds(i * 30),
+                             Money::fromCents(income ? 300000 : 1000 + static_cast<std::int64_t>(i % 9000)),
+                             income ? TransactionKind::Income : TransactionKind::Expense,
+                             income ? "monthly salary" : "card payment",
+                             income ? kCategories[0] : kCategories[1 + i % (kCategories.size() - 1)],
+                             income ? "Income" : "Expense",
+                             income ? other : "IT00BENCH",
+                             income ? "IT00BENCH" : other};
+}
+
+static std::unique_ptr<BankAccount> makeAccount() {
+    return std::make_unique<BankAccount>("Bench", "IT00BENCH", kPwd);
+}
+
+static void fill(BankAccount& account, std::size_t rows) {
+    // Blocchi da 64K righe: gli ID del blocco devono restare vivi fino all'inserimento
+    constexpr std::size_t kChunk = 1 << 16;
+    std::vector<std::string> ids(kChunk);
+    std::vector<TransactionRecord> batch;
+    batch.reserve(kChunk);
+    for (std::size_t first = 0; first < rows; first += kChunk) {
+        batch.clear();
+        for (std::size_t i = first; i < std::min(rows, first + kChunk); ++i) {
+            batch.push_back(makeRecord(i, ids[i - first]));
+        }
+        account.addTransactions(batch);
+    }
+}
+
+// Un conto popolato e il suo CSV per dimensione, costruiti alla prima richiesta
+struct Dataset {
+    std::unique_ptr<BankAccount> account;
+    std::string csv;
+    std::uintmax_t csvBytes = 0;
+    double rowBytes = 0;
+};
+
+static Dataset& dataset(std::size_t rows) {
+    static std::map<std::size_t, Dataset> cache;
+    Dataset& d = cache[rows];
+    if (!d.account) {
+        d.account = makeAccount();
+        fill(*d.account, rows);
+        d.csv = "bench_bank_account_" + std::to_string(rows) + ".csv";
+        d.account->SaveToFile(d.csv, kPwd);
+        d.csvBytes = std::filesystem::file_size(d.csv);
+        d.rowBytes = static_cast<double>(d.csvBytes) / static_cast<double>(rows);
+        // Il file viene rimosso all'uscita
+        static const struct Cleanup {
+            ~Cleanup() {
+                for (const auto& [n, data] : cache) std::remove(data.csv.c_str());
+            }
+        } cleanup;
+    }
+    return d;
+}
+
+static void setRows(benchmark::State& state, std::size_t rowsPerOp) {
+    state.SetItemsProcessed(static_cast<std::int64_t>(rowsPerOp) * state.iterations());
+}
+
+// --- Benchmark ---
+
+// Un conto nuovo riempito riga per riga fino a N
+static void BM_AddTransaction(benchmark::State& state) {
+    const auto rows = static_cast<std::size_t>(state.range(0));
+    const Dataset& d = dataset(rows);
+    std::string id;
+    AllocationCounter allocs;
+    for (auto _ : state) {
+        auto account = makeAccount();
+        for (std::size_t i = 0; i < rows; ++i) account->addTransaction(makeRecord(i, id));
+        state.PauseTiming();
+        account.reset();
+        state.ResumeTiming();
+    }
+    allocs.report(state);
+    setRows(state, rows);
+    state.SetBytesProcessed(static_cast<std::int64_t>(static_cast<double>(rows) * d.rowBytes) * state.iterations());
+}
+
+static void BM_Balance(benchmark::State& state) {
+    const Dataset& d = dataset(static_cast<std::size_t>(state.range(0)));
+    AllocationCounter allocs;
+    for (auto _ : state) benchmark::DoNotOptimize(d.account->balance());
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ComputeSummary(benchmark::State& state) {
+    const Dataset& d = dataset(static_cast<std::size_t>(state.range(0)));
+    AllocationCounter allocs;
+    for (auto _ : state) benchmark::DoNotOptimize(d.account->computeSummary());
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// ID esistenti in ordine pseudo-casuale (cache fredda sugli indici grandi)
+static void BM_FindTransactionById(benchmark::State& state) {
+    const auto rows = static_cast<std::size_t>(state.range(0));
+    const Dataset& d = dataset(rows);
+    std::vector<std::string> ids(1024);
+    for (std::size_t i = 0; i < ids.size(); ++i) ids[i] = "TX-" + std::to_string((i * 2654435761u) % rows);
+    std::size_t next = 0;
+    AllocationCounter allocs;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(d.account->findTransactionById(ids[next++ % ids.size()]));
+    }
+    allocs.report(state);
+    setRows(state, 1);
+}
+
+static void BM_FilterByType(benchmark::State& state) {
+    const Dataset& d = dataset(static_cast<std::size_t>(state.range(0)));
+    std::size_t found = 0;
+    AllocationCounter allocs;
+    for (auto _ : state) {
+        const auto rows = d.account->filterByType("Income");
+        found = rows.size();
+        benchmark::DoNotOptimize(rows.data());
+    }
+    allocs.report(state);
+    setRows(state, found);
+}
+
+static void BM_FilterByCounterparty(benchmark::State& state) {
+    const Dataset& d = dataset(static_cast<std::size_t>(state.range(0)));
+    const std::string& other = counterparties()[7];
+    std::size_t found = 0;
+    AllocationCounter allocs;
+    for (auto _ : state) {
+        const auto rows = d.account->filterByCounterparty(other);
+        found = rows.size();
+        benchmark::DoNotOptimize(rows.data());
+    }
+    allocs.report(state);
+    setRows(state, found);
+}
+
+static void BM_GetSortedTransactions(benchmark::State& state) {
+    const auto rows = static_cast<std::size_t>(state.range(0));
+    const Dataset& d = dataset(rows);
+    AllocationCounter allocs;
+    for (auto _ : state) {
+        const auto sorted = d.account->getSortedTransactions();
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    allocs.report(state);
+    setRows(state, rows);
+}
+
+static void BM_SaveToFile(benchmark::State& state) {
+    const auto rows = static_cast<std::size_t>(state.range(0));
+    const Dataset& d = dataset(rows);
+    const std::string file = "bench_bank_account_save.csv";
+    AllocationCounter allocs;
+    for (auto _ : state) d.account->SaveToFile(file, kPwd);
+    allocs.report(state);
+    setRows(state, rows);
+    state.SetBytesProcessed(static_cast<std::int64_t>(d.csvBytes) * state.iterations());
+    std::remove(file.c_str());
+}
+
+static void BM_ReadFromFile(benchmark::State& state) {
+    const auto rows = static_cast<std::size_t>(state.range(0));
+    const Dataset& d = dataset(rows);
+    AllocationCounter allocs;
+    for (auto _ : state) {
+        auto account = makeAccount();
+        account->ReadFromFile(d.csv, kPwd);
+        state.PauseTiming();
+        account.reset();
+        state.ResumeTiming();
+    }
+    allocs.report(state);
+    setRows(state, rows);
+    state.SetBytesProcessed(static_cast<std::int64_t>(d.csvBytes) * state.iterations());
+}
+
+static void Rows(benchmark::internal::Benchmark* b) {
+    for (std::int64_t n = 1000; n <= 10000000; n *= 10) b->Arg(n);
+    b->ArgName("rows");
+}
+
+BENCHMARK(BM_AddTransaction)->Apply(Rows)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Balance)->Apply(Rows);
+BENCHMARK(BM_ComputeSummary)->Apply(Rows);
+BENCHMARK(BM_FindTransactionById)->Apply(Rows);
+BENCHMARK(BM_FilterByType)->Apply(Rows)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_FilterByCounterparty)->Apply(Rows)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetSortedTransactions)->Apply(Rows)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SaveToFile)->Apply(Rows)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReadFromFile)->Apply(Rows)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,83 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+// Throughput di letture e scritture concorrenti sullo stesso conto:
+// ConcurrencyMode::Exclusive (un solo mutex) contro SharedReaders.
+// Uso: bench_concurrency [lettori] [righe per scrittore]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Bank_Account.h"
+
+using namespace std::chrono;
+
+struct Result {
+    double writesPerSec;
+    double readsPerSec;
+};
+
+static Result run(ConcurrencyMode mode, unsigned readers, int rows) {
+    BankAccount account("Alice", "BankA", "pwd");
+    account.setConcurrencyMode(mode);
+    // Storia iniziale: le letture hanno qualcosa da scandire
+    const TimePoint start = system_clock::now();
+    std::vector<std::string> ids;
+    for (int i = 0; i < 20000 + rows; ++i) ids.push_back("TX-" + std::to_string(i));
+    for (int i = 0; i < 20000; ++i) {
+        account.addTransaction(TransactionRecord{ids[i], start + seconds(i), Money::fromCents(100),
+                                                 TransactionKind::Income, "seed", "salary", "Income",
+                                                 "Alice", "Alice"});
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<long> reads{0};
+    std::vector<std::thread> threads;
+    for (unsigned r = 0; r < readers; ++r) {
+        threads.emplace_back([&] {
+            long local = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                switch (local++ % 3) {
+                    case 0: (void) account.balance(); break;
+                    case 1: (void) account.filterByType("Income").size(); break;
+                    default: (void) account.computeStatistics(); break;
+                }
+            }
+            reads += local;
+        });
+    }
+
+    const auto t0 = steady_clock::now();
+    for (int i = 0; i < rows; ++i) {
+        account.addTransaction(TransactionRecord{ids[20000 + i], start + seconds(20000 + i),
+                                                 Money::fromCents(100), TransactionKind::Income, "bench",
+                                                 "salary", "Income", "Alice", "Alice"});
+    }
+    const auto t1 = steady_clock::now();
+    // Finestra di sola lettura di durata pari alla scrittura, poi stop
+    std::this_thread::sleep_for(t1 - t0);
+    done = true;
+    for (auto& t : threads) t.join();
+    const double secs = duration<double>(steady_clock::now() - t0).count();
+    return Result{rows / duration<double>(t1 - t0).count(), reads.load() / secs};
+}
+
+int main(int argc, char** argv) {
+    const unsigned readers = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1]))
+                                      : std::max(1u, std::thread::hardware_concurrency());
+    const int rows = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+    std::cout << "1 writer, " << readers << " readers, " << rows << " rows\n";
+    for (const auto mode : {ConcurrencyMode::Exclusive, ConcurrencyMode::SharedReaders}) {
+        const Result r = run(mode, readers, rows);
+        std::cout << (mode == ConcurrencyMode::Exclusive ? "Exclusive     " : "SharedReaders ")
+                  << "writes/s: " << static_cast<long>(r.writesPerSec)
+                  << "  reads/s: " << static_cast<long>(r.readsPerSec) << '\n';
+    }
+    return 0;
+}
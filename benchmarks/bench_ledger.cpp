@@ -0,0 +1,65 @@
+//
+// Created by Andrea Peli on 17/10/26.
+//
+// Throughput dei trasferimenti di Ledger con migliaia di conti.
+// disjoint: ogni thread sposta denaro solo fra i conti della propria partizione;
+// random: coppie qualsiasi (possibili contese sugli stessi conti).
+// Uso: bench_ledger [conti] [thread] [trasferimenti per thread]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Ledger.h"
+
+using namespace std::chrono;
+
+static double run(bool disjoint, std::size_t accounts, unsigned threads, int perThread) {
+    Ledger ledger;
+    std::vector<std::string> banks;
+    banks.reserve(accounts);
+    for (std::size_t i = 0; i < accounts; ++i) {
+        banks.push_back("IT" + std::to_string(100000 + i));
+        BankAccount& account = ledger.openAccount("Owner" + std::to_string(i), banks.back(), "pwd");
+        account.addTransaction(TransactionRecord{"SEED-" + banks.back(), system_clock::now(),
+                                                 Money::fromCents(1000000), TransactionKind::Income,
+                                                 "seed", "Salary", "Income", "EXT", banks.back()});
+    }
+
+    std::vector<std::thread> pool;
+    const auto t0 = steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            std::mt19937_64 rng(42 + t);
+            const std::size_t width = disjoint ? std::max<std::size_t>(2, accounts / threads) : accounts;
+            const std::size_t base = disjoint ? (t * width) % accounts : 0;
+            std::uniform_int_distribution<std::size_t> pick(0, std::min(width, accounts - base) - 1);
+            const std::string prefix = "T" + std::to_string(t) + "-";
+            for (int i = 0; i < perThread; ++i) {
+                const std::size_t from = base + pick(rng);
+                std::size_t to = base + pick(rng);
+                if (to == from) to = from == base ? from + 1 : base;
+                ledger.transfer(banks[from], banks[to], Money::fromCents(1), prefix + std::to_string(i), "bench");
+            }
+        });
+    }
+    for (auto& th : pool) th.join();
+    const double secs = duration<double>(steady_clock::now() - t0).count();
+    return threads * perThread / secs;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t accounts = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    const unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2]))
+                                      : std::max(1u, std::thread::hardware_concurrency());
+    const int perThread = argc > 3 ? std::atoi(argv[3]) : 100000;
+
+    std::cout << accounts << " accounts, " << threads << " threads, " << perThread << " transfers/thread\n";
+    std::cout << "disjoint  transfers/s: " << static_cast<long>(run(true, accounts, threads, perThread)) << '\n';
+    std::cout << "random    transfers/s: " << static_cast<long>(run(false, accounts, threads, perThread)) << '\n';
+    return 0;
+}
@@ -24,7 +24,7 @@ static std::unique_ptr<Transaction> mk_income(
     const string& senderAcc,
     const string& receiverAcc)
 {
-    return std::make_unique<Income>(id, nowtp(), amount, description, category, opType, senderAcc, receiverAcc);
+    return std::make_unique<Income>(id, nowtp(), Money::fromDouble(amount), description, category, opType, senderAcc, receiverAcc);
 }
 
 static std::unique_ptr<Transaction> mk_expense(
@@ -35,7 +35,7 @@ static std::unique_ptr<Transaction> mk_expense(
     const string& senderAcc,
     const string& receiverAcc)
 {
-    return std::make_unique<Expense>(id, nowtp(), amount, description, category, opType, senderAcc, receiverAcc);
+    return std::make_unique<Expense>(id, nowtp(), Money::fromDouble(amount), description, category, opType, senderAcc, receiverAcc);
 }
 
 int main() {
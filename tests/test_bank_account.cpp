@@ -6,8 +6,30 @@
 #include "Bank_Account.h"
 #include "Income.h"
 #include "Expense.h"
+#include "Csv_Reader.h"
+#include "Snapshot.h"
+#include "Journal.h"
+#include "Aggregate_Kernels.h"
+#include "String_Dictionary.h"
+#include "Ledger.h"
+#include "Ledger_Generator.h"
+#include "Report_Renderer.h"
 #include <chrono>
 #include <memory>
+#include <format>
+#include <functional>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <memory_resource>
+#include <thread>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 
 using namespace std::chrono;
@@ -30,27 +52,27 @@ protected:
 
     std::unique_ptr<Income> makeIncome(double amount, const std::string& desc = "income", const std::string& id = "INC-001") {
         return std::make_unique<Income>(
-            id, now, amount, desc, "salary", "Income", "Alice", "Alice");
+            id, now, Money::fromDouble(amount), desc, "salary", "Income", "Alice", "Alice");
     }
 
     std::unique_ptr<Expense> makeExpense(double amount, const std::string& desc = "expense", const std::string& id = "EXP-001") {
         return std::make_unique<Expense>(
-            id, now, amount, desc, "general", "Expense", "Alice", "Alice");
+            id, now, Money::fromDouble(amount), desc, "general", "Expense", "Alice", "Alice");
     }
 };
 
 TEST_F(TestBankAccount, BasicTransactionsAndBalance) {
     auto income = makeIncome(100.0, "paycheck", "INC-001");
     accountA->addTransaction(std::move(income));
-    EXPECT_DOUBLE_EQ(accountA->balance(), 100.0);
+    EXPECT_EQ(accountA->balance(), Money::fromCents(10000));
 
     auto expense = makeExpense(40.0, "groceries", "EXP-001");
     accountA->addTransaction(std::move(expense));
-    EXPECT_DOUBLE_EQ(accountA->balance(), 60.0);
+    EXPECT_EQ(accountA->balance(), Money::fromCents(6000));
 
     accountA->addTransaction(std::move(makeIncome(50.0, "bonus", "INC-002")));
     accountA->addTransaction(std::move(makeExpense(10.0, "snacks", "EXP-002")));
-    EXPECT_DOUBLE_EQ(accountA->balance(), 100.0);
+    EXPECT_EQ(accountA->balance(), Money::fromCents(10000));
 }
 
 TEST_F(TestBankAccount, WithdrawMoreThanBalanceThrows) {
@@ -67,25 +89,25 @@ TEST_F(TestBankAccount, FilterByTypeAndCounterparty) {
 
     auto incomes = accountA->filterByType("Income");
     EXPECT_GE(incomes.size(), 2);
-    for (const auto* t : incomes) {
-        EXPECT_EQ(t->getType(), "Income");
+    for (const auto& t : incomes) {
+        EXPECT_EQ(t.getType(), "Income");
     }
 
     auto expenses = accountA->filterByType("Expense");
     EXPECT_GE(expenses.size(), 2);
-    for (const auto* t : expenses) {
-        EXPECT_EQ(t->getType(), "Expense");
+    for (const auto& t : expenses) {
+        EXPECT_EQ(t.getType(), "Expense");
     }
 
     // Add a transfer transaction from accountA to accountA2
     auto transferIncome = std::make_unique<Income>(
-        "INC-006", now, 50.0, "transfer", "transfer", "Income", "Alice", "Alice");
+        "INC-006", now, Money::fromCents(5000), "transfer", "transfer", "Income", "Alice", "Alice");
     accountA->addTransaction(std::move(transferIncome), accountA2.get());
 
     auto filteredByCounterparty = accountA->filterByCounterparty("Alice");
     EXPECT_GE(filteredByCounterparty.size(), 1);
-    for (const auto* t : filteredByCounterparty) {
-        EXPECT_EQ(t->getReceiverAccount(), "Alice");
+    for (const auto& t : filteredByCounterparty) {
+        EXPECT_EQ(t.getReceiverAccount(), "Alice");
     }
 }
 
@@ -98,7 +120,7 @@ TEST_F(TestBankAccount, PrintFunctionsWithPassword) {
 
     auto incomes = accountA->filterByType("Income");
     if (!incomes.empty()) {
-        const std::string txId = incomes[0]->getId();
+        const std::string txId{incomes[0].getId()};
         EXPECT_NO_THROW(accountA->printTransactionById(pwdA, txId));
     }
 
@@ -107,7 +129,7 @@ TEST_F(TestBankAccount, PrintFunctionsWithPassword) {
 
     // Wrong password should throw when printing by id
     if (!incomes.empty()) {
-        const std::string txId = incomes[0]->getId();
+        const std::string txId{incomes[0].getId()};
         EXPECT_THROW(accountA->printTransactionById("wrongpwd", txId), std::runtime_error);
     }
 }
@@ -117,7 +139,7 @@ TEST_F(TestBankAccount, SaveToFileAndReadFromFileRoundTrip) {
     accountA->addTransaction(std::move(makeExpense(40.0, "groceries", "EXP-007")));
 
     auto transferIncome = std::make_unique<Income>(
-        "INC-009", now, 50.0, "transfer", "transfer", "Income", "Alice", "Alice");
+        "INC-009", now, Money::fromCents(5000), "transfer", "transfer", "Income", "Alice", "Alice");
     accountA->addTransaction(std::move(transferIncome), accountA2.get());
 
     const std::string filename = "test_account.csv";
@@ -128,26 +150,1425 @@ TEST_F(TestBankAccount, SaveToFileAndReadFromFileRoundTrip) {
     EXPECT_NO_THROW(loadedAccount.ReadFromFile(filename, pwdA));
 
     EXPECT_EQ(accountA->getOwnerId(), loadedAccount.getOwnerId());
-    EXPECT_DOUBLE_EQ(accountA->balance(), loadedAccount.balance());
+    EXPECT_EQ(accountA->balance(), loadedAccount.balance());
 
     // Check that transactions match by id and amount
     auto origIncomes = accountA->filterByType("Income");
     auto loadedIncomes = loadedAccount.filterByType("Income");
     EXPECT_EQ(origIncomes.size(), loadedIncomes.size());
     for (size_t i = 0; i < origIncomes.size(); ++i) {
-        EXPECT_EQ(origIncomes[i]->getId(), loadedIncomes[i]->getId());
-        EXPECT_DOUBLE_EQ(origIncomes[i]->getAmount(), loadedIncomes[i]->getAmount());
-        EXPECT_EQ(origIncomes[i]->getDescription(), loadedIncomes[i]->getDescription());
+        EXPECT_EQ(origIncomes[i].getId(), loadedIncomes[i].getId());
+        EXPECT_EQ(origIncomes[i].getAmount(), loadedIncomes[i].getAmount());
+        EXPECT_EQ(origIncomes[i].getDescription(), loadedIncomes[i].getDescription());
     }
 
     auto origExpenses = accountA->filterByType("Expense");
     auto loadedExpenses = loadedAccount.filterByType("Expense");
     EXPECT_EQ(origExpenses.size(), loadedExpenses.size());
     for (size_t i = 0; i < origExpenses.size(); ++i) {
-        EXPECT_EQ(origExpenses[i]->getId(), loadedExpenses[i]->getId());
-        EXPECT_DOUBLE_EQ(origExpenses[i]->getAmount(), loadedExpenses[i]->getAmount());
-        EXPECT_EQ(origExpenses[i]->getDescription(), loadedExpenses[i]->getDescription());
+        EXPECT_EQ(origExpenses[i].getId(), loadedExpenses[i].getId());
+        EXPECT_EQ(origExpenses[i].getAmount(), loadedExpenses[i].getAmount());
+        EXPECT_EQ(origExpenses[i].getDescription(), loadedExpenses[i].getDescription());
     }
 
     std::remove(filename.c_str());
-}
\ No newline at end of file
+}
+TEST_F(TestBankAccount, SummaryTracksEveryInsert) {
+    accountA->addTransaction(std::move(makeIncome(100.0, "salary", "INC-010")));
+    accountA->addTransaction(std::move(makeExpense(30.0, "rent", "EXP-010")));
+    accountA->addTransaction(std::move(makeIncome(5.5, "refund", "INC-011")));
+
+    const auto summary = accountA->computeSummary();
+    EXPECT_EQ(summary.deposits, Money::fromCents(10550));
+    EXPECT_EQ(summary.withdrawals, Money::fromCents(3000));
+    EXPECT_EQ(summary.balance, Money::fromCents(7550));
+    EXPECT_EQ(accountA->balance(), Money::fromCents(7550));
+
+    const std::string filename = "test_summary.csv";
+    accountA->SaveToFile(filename, pwdA);
+    accountA->ReadFromFile(filename, pwdA);
+    const auto reloaded = accountA->computeSummary();
+    EXPECT_EQ(reloaded.deposits, Money::fromCents(10550));
+    EXPECT_EQ(reloaded.withdrawals, Money::fromCents(3000));
+    EXPECT_EQ(reloaded.balance, Money::fromCents(7550));
+    std::remove(filename.c_str());
+}
+
+TEST_F(TestBankAccount, MoneyIsExactFixedPoint) {
+    EXPECT_EQ(Money::parse("1234,5"), Money::fromCents(123450));
+    EXPECT_EQ(Money::parse("0.07"), Money::fromCents(7));
+    EXPECT_EQ(Money::parse("-0,01"), Money::fromCents(-1));
+    EXPECT_EQ(Money::parse("92233720368547758,07"), Money::fromCents(INT64_MAX));
+    EXPECT_THROW(Money::parse("92233720368547758,08"), std::runtime_error);
+    EXPECT_THROW(Money::parse("1,234"), std::runtime_error);
+    EXPECT_THROW(Money::parse("1,"), std::runtime_error);
+    EXPECT_THROW(Money::parse(""), std::runtime_error);
+    EXPECT_THROW(Money::fromDouble(1e300), std::runtime_error);
+
+    EXPECT_EQ(Money::fromCents(-5).toString(','), "-0,05");
+    EXPECT_EQ(Money::fromCents(INT64_MIN).toString(), "-92233720368547758.08");
+    EXPECT_EQ(Money::fromDouble(0.1).cents(), 10);
+
+    // 0.1 + 0.2 drifts with doubles, never with cents
+    Money sum;
+    for (int i = 0; i < 1'000'000; ++i) sum += Money::fromDouble(0.1);
+    EXPECT_EQ(sum, Money::fromCents(10'000'000));
+}
+
+TEST_F(TestBankAccount, BulkIngestionIsLinear) {
+    auto ingest = [&](std::size_t n) {
+        BankAccount account("Carol", "BankC", "passwordC");
+        const auto start = steady_clock::now();
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::string id = std::to_string(i);
+            if (i % 2 == 0) account.addTransaction(makeIncome(2.0, "in", "INC-" + id));
+            else            account.addTransaction(makeExpense(1.0, "out", "EXP-" + id));
+        }
+        const auto elapsed = duration<double>(steady_clock::now() - start).count();
+        EXPECT_EQ(account.balance(), Money::fromCents(static_cast<std::int64_t>(n / 2) * 100));
+        return elapsed;
+    };
+
+    const double small = ingest(100'000);
+    const double large = ingest(1'000'000);
+    // 10x rows: linear is ~10x, quadratic would be ~100x
+    EXPECT_LT(large, small * 30);
+}
+
+TEST_F(TestBankAccount, ColumnarStoreViewsMatchInput) {
+    accountA->addTransaction(std::move(makeIncome(100.0, "salary", "INC-012")));
+    accountA->addTransaction(std::move(makeExpense(25.0, "books", "EXP-012")));
+
+    accountA->read([](const TransactionStore& store) {
+        ASSERT_EQ(store.size(), 2u);
+        EXPECT_EQ(store.amounts()[1], Money::fromCents(2500));
+        EXPECT_EQ(store.kinds()[1], TransactionKind::Expense);
+    });
+
+    const auto found = accountA->findTransactionById("EXP-012");
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(found->getDescription(), "books");
+    EXPECT_EQ(found->getCategory(), "general");
+    EXPECT_EQ(found->getType(), "Expense");
+    EXPECT_EQ(found->getValue(), Money::fromCents(-2500));
+    EXPECT_EQ(found->getData(), now);
+    EXPECT_FALSE(accountA->findTransactionById("NOPE").has_value());
+}
+
+TEST_F(TestBankAccount, DuplicateIdsAreRejected) {
+    accountA->addTransaction(std::move(makeIncome(100.0, "salary", "INC-013")));
+    EXPECT_THROW(accountA->addTransaction(std::move(makeIncome(10.0, "again", "INC-013"))),
+                 std::runtime_error);
+    EXPECT_EQ(accountA->transactionCount(), 1u);
+    EXPECT_EQ(accountA->balance(), Money::fromCents(10000));
+
+    for (int i = 0; i < 1000; ++i) {
+        accountA->addTransaction(makeIncome(1.0, "bulk", "BULK-" + std::to_string(i)));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        const auto t = accountA->findTransactionById("BULK-" + std::to_string(i));
+        ASSERT_TRUE(t.has_value());
+        EXPECT_EQ(t->getId(), "BULK-" + std::to_string(i));
+    }
+}
+
+TEST_F(TestBankAccount, ReadFromFileRejectsDuplicateIds) {
+    const std::string filename = "test_duplicates.csv";
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "\xEF\xBB\xBF" << "Account Owner: Alice, Bank: BankA\n"
+            << "\"ID\";\"Date\";\"Amount\";\"Operation\";\"Category\";\"Description\";\"Sender\";\"Receiver\"\r\n"
+            << "\"INC-1\";\"2025-11-15 10:00:00\";\"10,00\";\"Income\";\"salary\";\"a\";\"X\";\"BankA\"\r\n"
+            << "\"INC-1\";\"2025-11-15 10:00:00\";\"10,00\";\"Income\";\"salary\";\"a\";\"X\";\"BankA\"\r\n";
+    }
+    EXPECT_THROW(accountA->ReadFromFile(filename, pwdA), std::runtime_error);
+    std::remove(filename.c_str());
+}
+
+TEST_F(TestBankAccount, SecondaryIndexesMatchFullScan) {
+    for (int i = 0; i < 200; ++i) {
+        const std::string id = std::to_string(i);
+        const std::string peer = "Peer" + std::to_string(i % 7);
+        accountA->addTransaction(std::make_unique<Income>(
+            "INC-" + id, now, Money::fromCents(1000), "in", "salary", "Income", peer, "BankA"));
+        accountA->addTransaction(std::make_unique<Expense>(
+            "EXP-" + id, now, Money::fromCents(500), "out", "general", "Expense", "BankA", peer));
+    }
+
+    auto ids = [](const std::vector<TransactionRow>& rows) {
+        std::vector<std::string> out;
+        for (const auto& t : rows) out.emplace_back(t.getId());
+        return out;
+    };
+    const auto indexedIncome = ids(accountA->filterByType("Income"));
+    const auto indexedPeer = ids(accountA->filterByCounterparty("Peer3"));
+    const auto indexedOwn = ids(accountA->filterByCounterparty("BankA"));
+
+    accountA->setSecondaryIndexes(false);
+    EXPECT_EQ(indexedIncome, ids(accountA->filterByType("Income")));
+    EXPECT_EQ(indexedPeer, ids(accountA->filterByCounterparty("Peer3")));
+    EXPECT_EQ(indexedOwn, ids(accountA->filterByCounterparty("BankA")));
+    EXPECT_EQ(indexedIncome.size(), 200u);
+    EXPECT_EQ(indexedOwn.size(), 400u);
+
+    accountA->setSecondaryIndexes(true);
+    EXPECT_EQ(indexedPeer, ids(accountA->filterByCounterparty("Peer3")));
+    EXPECT_TRUE(accountA->filterByType("Transfer").empty());
+}
+
+TEST_F(TestBankAccount, StoreKeepsTimeOrderAndAnswersRanges) {
+    const auto base = now;
+    accountA->addTransaction(std::make_unique<Income>(
+        "T-3", base + hours(3), Money::fromCents(3000), "c", "salary", "Income", "X", "BankA"));
+    accountA->addTransaction(std::make_unique<Income>(
+        "T-1", base + hours(1), Money::fromCents(1000), "a", "salary", "Income", "X", "BankA"));
+    accountA->addTransaction(std::make_unique<Income>(
+        "T-4", base + hours(4), Money::fromCents(4000), "d", "salary", "Income", "X", "BankA"));
+    accountA->addTransaction(std::make_unique<Income>(
+        "T-2", base + hours(2), Money::fromCents(2000), "b", "salary", "Income", "X", "BankA"));
+
+    std::vector<std::string> order;
+    for (const auto& t : accountA->getSortedTransactions()) order.emplace_back(t.getId());
+    EXPECT_EQ(order, (std::vector<std::string>{"T-1", "T-2", "T-3", "T-4"}));
+
+    const auto range = accountA->between(base + hours(2), base + hours(4));
+    ASSERT_EQ(range.size(), 2u);
+    EXPECT_EQ(range[0].getId(), "T-2");
+    EXPECT_EQ(range[1].getId(), "T-3");
+    EXPECT_TRUE(accountA->between(base + hours(5), base + hours(6)).empty());
+}
+
+TEST_F(TestBankAccount, BatchAppendMergesLateArrivals) {
+    TransactionStore store;
+    std::vector<std::string> ids;
+    std::vector<TransactionRecord> batch;
+    for (int i = 0; i < 100; ++i) ids.push_back("B-" + std::to_string(i));
+    for (int i = 0; i < 50; ++i) {
+        store.append(TransactionRecord{ids[i], now + seconds(2 * i), Money::fromCents(100),
+                                       TransactionKind::Income, "d", "c", "Income", "S", "R"});
+    }
+    for (int i = 50; i < 100; ++i) {
+        // Odd seconds interleave with the rows already stored
+        batch.push_back(TransactionRecord{ids[i], now + seconds(2 * (99 - i) + 1), Money::fromCents(100),
+                                          TransactionKind::Income, "d", "c", "Income", "S", "R"});
+    }
+    store.appendBatch(batch);
+
+    const auto rows = store.rowsByTime();
+    ASSERT_EQ(rows.size(), 100u);
+    for (std::size_t i = 1; i < rows.size(); ++i) {
+        EXPECT_LT(store.timestamps()[rows[i - 1]], store.timestamps()[rows[i]]);
+    }
+}
+
+TEST_F(TestBankAccount, SingleLateAppendsMergeOnRead) {
+    TransactionStore store;
+    std::vector<std::string> ids;
+    for (int i = 0; i < 65; ++i) ids.push_back("L-" + std::to_string(i));
+    const auto add = [&](int i, int second) {
+        store.append(TransactionRecord{ids[i], now + seconds(second), Money::fromCents(100),
+                                       TransactionKind::Income, "d", "c", "Income", "S", "R"});
+    };
+    for (int i = 0; i < 20; ++i) add(i, 3 * i);
+    // Late rows one at a time, some on timestamps already present
+    for (int i = 20; i < 40; ++i) add(i, 3 * (39 - i) + (i % 2 ? 0 : 1));
+
+    const auto inOrder = [&](std::span<const std::uint32_t> rows) {
+        for (std::size_t i = 1; i < rows.size(); ++i) {
+            const auto a = rows[i - 1], b = rows[i];
+            const auto ta = store.timestamps()[a], tb = store.timestamps()[b];
+            if (ta > tb || (ta == tb && a > b)) return false;
+        }
+        return true;
+    };
+    EXPECT_EQ(store.rowsBetween(now + seconds(3), now + seconds(9)).size(), 4u);
+    EXPECT_EQ(store.rowsByTime().size(), 40u);
+    EXPECT_TRUE(inOrder(store.rowsByTime()));
+
+    // More late rows, then a batch and a truncate: the pending tail goes with them
+    for (int i = 40; i < 50; ++i) add(i, 100 - i);
+    std::vector<TransactionRecord> batch;
+    for (int i = 50; i < 60; ++i) {
+        batch.push_back(TransactionRecord{ids[i], now + seconds(2 * i), Money::fromCents(100),
+                                          TransactionKind::Income, "d", "c", "Income", "S", "R"});
+    }
+    store.appendBatch(batch);
+    EXPECT_EQ(store.rowsByTime().size(), 60u);
+    EXPECT_TRUE(inOrder(store.rowsByTime()));
+
+    for (int i = 60; i < 65; ++i) add(i, 1);
+    store.truncate(58);
+    EXPECT_EQ(store.rowsByTime().size(), 58u);
+    EXPECT_TRUE(inOrder(store.rowsByTime()));
+}
+
+TEST_F(TestBankAccount, CsvRoundTripKeepsEveryField) {
+    const auto when = sys_days{2025y / November / 15} + hours(9) + minutes(30) + seconds(5);
+    accountA->addTransaction(std::make_unique<Income>(
+        "INC-014", when, Money::fromCents(123456), "rent; march, april", "housing", "Income", "Tenant", "BankA"));
+    accountA->addTransaction(std::make_unique<Expense>(
+        "EXP-014", when + minutes(1), Money::fromCents(50), "coffee", "food", "Expense", "BankA", "Bar"));
+
+    const std::string filename = "test_fields.csv";
+    accountA->SaveToFile(filename, pwdA);
+    BankAccount loaded("Alice", "BankA", pwdA);
+    loaded.ReadFromFile(filename, pwdA);
+    std::remove(filename.c_str());
+
+    const auto in = loaded.findTransactionById("INC-014");
+    ASSERT_TRUE(in.has_value());
+    EXPECT_EQ(in->getData(), when);
+    EXPECT_EQ(in->getAmount(), Money::fromCents(123456));
+    EXPECT_EQ(in->getDescription(), "rent; march, april");
+    EXPECT_EQ(in->getCategory(), "housing");
+    EXPECT_EQ(in->getSenderAccount(), "Tenant");
+    EXPECT_EQ(in->getReceiverAccount(), "BankA");
+
+    const auto out = loaded.findTransactionById("EXP-014");
+    ASSERT_TRUE(out.has_value());
+    EXPECT_EQ(out->getKind(), TransactionKind::Expense);
+    EXPECT_EQ(out->getReceiverAccount(), "Bar");
+    EXPECT_EQ(loaded.balance(), Money::fromCents(123406));
+}
+
+TEST_F(TestBankAccount, CsvReaderReportsMalformedInput) {
+    TransactionRecord record;
+    EXPECT_THROW(CsvReader::parseLine("\"a\";\"b\"", record), std::runtime_error);
+    EXPECT_THROW(CsvReader::parseDateTime("2025-13-01 00:00:00"), std::runtime_error);
+    EXPECT_THROW(CsvReader::parseDateTime("2025-11-15"), std::runtime_error);
+    EXPECT_THROW(CsvReader::parseAmount("12,3x"), std::runtime_error);
+    EXPECT_EQ(CsvReader::parseAmount("-12,30"), Money::fromCents(-1230));
+
+    CsvReader reader("Account Owner: Bob, Bank: BankB\n"
+                     "header\r\n"
+                     "\"X-1\";\"2025-11-15 10:00:00\";\"1,00\";\"Refund\";\"c\";\"d\";\"s\";\"r\"\r\n");
+    EXPECT_EQ(reader.readPreamble().bank, "BankB");
+    try {
+        reader.next(record);
+        FAIL() << "expected an exception";
+    } catch (const std::runtime_error& ex) {
+        EXPECT_STREQ(ex.what(), "Unknown Operation in CSV: Refund");
+    }
+    EXPECT_THROW(accountA->ReadFromFile("missing_file.csv", pwdA), std::runtime_error);
+}
+
+TEST_F(TestBankAccount, ParallelImportMatchesSequential) {
+    const auto base = sys_days{2025y / January / 1};
+    for (int i = 0; i < 20000; ++i) {
+        const std::string id = std::to_string(i);
+        if (i % 3 == 2) {
+            accountA->addTransaction(std::make_unique<Expense>(
+                "EXP-" + id, base + minutes(i), Money::fromCents(125), "expense number " + id, "general", "Expense",
+                "BankA", "Shop" + std::to_string(i % 11)));
+        } else {
+            accountA->addTransaction(std::make_unique<Income>(
+                "INC-" + id, base + minutes(i), Money::fromCents(250), "income number " + id, "salary", "Income",
+                "Payer" + std::to_string(i % 13), "BankA"));
+        }
+    }
+    const std::string filename = "test_parallel.csv";
+    accountA->SaveToFile(filename, pwdA);
+
+    BankAccount sequential("Alice", "BankA", pwdA);
+    BankAccount parallel("Alice", "BankA", pwdA);
+    sequential.ReadFromFile(filename, pwdA, 1);
+    parallel.ReadFromFile(filename, pwdA, 4);
+
+    ASSERT_EQ(parallel.transactionCount(), 20000u);
+    EXPECT_EQ(parallel.balance(), sequential.balance());
+    const auto seqRows = sequential.getSortedTransactions();
+    const auto parRows = parallel.getSortedTransactions();
+    for (std::size_t i = 0; i < seqRows.size(); ++i) {
+        ASSERT_EQ(seqRows[i].getId(), parRows[i].getId());
+        ASSERT_EQ(seqRows[i].getDescription(), parRows[i].getDescription());
+    }
+
+    // A bad row in the middle must surface the same error, after the same rows
+    std::string contents;
+    {
+        std::ifstream in(filename, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const auto bad = contents.find("\"INC-15000\"");
+    ASSERT_NE(bad, std::string::npos);
+    contents.insert(bad, "\"BROKEN\";\"not a date\";\"1,00\";\"Income\";\"c\";\"d\";\"s\";\"r\"\r\n");
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << contents;
+    }
+    std::string seqError, parError;
+    try { sequential.ReadFromFile(filename, pwdA, 1); } catch (const std::runtime_error& ex) { seqError = ex.what(); }
+    try { parallel.ReadFromFile(filename, pwdA, 4); } catch (const std::runtime_error& ex) { parError = ex.what(); }
+    EXPECT_EQ(seqError, "Invalid datetime format: not a date");
+    EXPECT_EQ(parError, seqError);
+    EXPECT_EQ(parallel.transactionCount(), sequential.transactionCount());
+
+    // A duplicate ID rejects the whole block in the store: the rows before it still stay
+    contents.replace(contents.find("\"BROKEN\""), std::string_view("\"BROKEN\"").size(), "\"INC-10\"");
+    contents.replace(contents.find("\"not a date\""), std::string_view("\"not a date\"").size(),
+                     "\"2025-01-01 00:00:00\"");
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << contents;
+    }
+    seqError.clear();
+    parError.clear();
+    try { sequential.ReadFromFile(filename, pwdA, 1); } catch (const std::runtime_error& ex) { seqError = ex.what(); }
+    try { parallel.ReadFromFile(filename, pwdA, 4); } catch (const std::runtime_error& ex) { parError = ex.what(); }
+    EXPECT_EQ(seqError, "Duplicate transaction ID: INC-10");
+    EXPECT_EQ(parError, seqError);
+    EXPECT_EQ(sequential.transactionCount(), 15000u);
+    EXPECT_EQ(parallel.transactionCount(), 15000u);
+
+    std::remove(filename.c_str());
+}
+
+TEST_F(TestBankAccount, SaveToFileOutputIsByteIdentical) {
+    const auto base = sys_days{2025y / March / 9} + hours(7) + milliseconds(250);
+    accountA->addTransaction(std::make_unique<Income>(
+        "INC-015", base, Money::fromCents(150001), "salary", "Salary", "Income", "Employer", "BankA"));
+    accountA->addTransaction(std::make_unique<Expense>(
+        "EXP-015", base + hours(30), Money::fromCents(9999), "phone; bill", "Utilities", "Expense", "BankA", "Telco"));
+    accountA->addTransaction(std::make_unique<Income>(
+        "INC-016", base - days(400), Money::fromCents(10), "interest", "Interest", "Income", "Bank", "BankA"));
+
+    // Reference rendering built the way SaveToFile used to do it
+    auto decimal = [](Money v) {
+        std::string s = std::format("{:.2f}", v.toDouble());
+        std::replace(s.begin(), s.end(), '.', ',');
+        return s;
+    };
+    std::string expected = "\xEF\xBB\xBF" + std::format("Account Owner: {}, Bank: {}\n", "Alice", "BankA");
+    expected += "\"ID\";\"Date\";\"Amount\";\"Operation\";\"Category\";\"Description\";\"Sender\";\"Receiver\"\r\n";
+    for (const auto& t : accountA->getSortedTransactions()) {
+        expected += std::format("\"{}\";\"{}\";\"{}\";\"{}\";\"{}\";\"{}\";\"{}\";\"{}\"\r\n",
+                                t.getId(), t.getDataFormatted().substr(0, 19), decimal(t.getAmount()),
+                                t.getOperationType(), t.getCategory(), t.getDescription(),
+                                t.getSenderAccount(), t.getReceiverAccount());
+    }
+    const auto summary = accountA->computeSummary();
+    expected += std::format("Summary; Total Deposits: {};Total Withdrawals: {};Final Balance: {}\r\n",
+                            decimal(summary.deposits), decimal(summary.withdrawals), decimal(summary.balance));
+
+    const std::string filename = "test_bytes.csv";
+    accountA->SaveToFile(filename, pwdA, true);
+    std::ifstream in(filename, std::ios::binary);
+    const std::string written{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    EXPECT_EQ(written, expected);
+    std::remove(filename.c_str());
+}
+
+TEST_F(TestBankAccount, SnapshotRoundTripAndConversions) {
+    const auto base = sys_days{2025y / June / 1};
+    accountA->addTransaction(std::make_unique<Income>(
+        "INC-017", base + hours(5), Money::fromCents(90000), "salary", "Salary", "Income", "Employer", "BankA"));
+    accountA->addTransaction(std::make_unique<Income>(
+        "INC-018", base + hours(1), Money::fromCents(1234), "early; refund", "Refund", "Income", "Shop", "BankA"));
+    accountA->addTransaction(std::make_unique<Expense>(
+        "EXP-016", base + hours(9), Money::fromCents(4560), "dinner", "Food", "Expense", "BankA", "Restaurant"));
+
+    const std::string snap = "test_account.snap";
+    accountA->SaveSnapshot(snap, pwdA);
+    BankAccount loaded("Alice", "BankA", pwdA);
+    loaded.LoadSnapshot(snap, pwdA);
+    EXPECT_EQ(loaded.balance(), accountA->balance());
+    ASSERT_EQ(loaded.transactionCount(), 3u);
+    const auto early = loaded.findTransactionById("INC-018");
+    ASSERT_TRUE(early.has_value());
+    EXPECT_EQ(early->getDescription(), "early; refund");
+    EXPECT_EQ(early->getData(), base + hours(1));
+    EXPECT_EQ(loaded.getSortedTransactions().front().getId(), "INC-018");
+
+    BankAccount wrongOwner("Bob", "BankA", pwdA);
+    EXPECT_THROW(wrongOwner.LoadSnapshot(snap, pwdA), std::runtime_error);
+
+    // CSV -> snapshot -> CSV keeps the file byte for byte
+    const std::string csv = "test_snapshot.csv";
+    const std::string csvAgain = "test_snapshot_again.csv";
+    accountA->SaveToFile(csv, pwdA);
+    snapshot::csvToSnapshot(csv, snap);
+    snapshot::snapshotToCsv(snap, csvAgain);
+    auto slurp = [](const std::string& name) {
+        std::ifstream in(name, std::ios::binary);
+        return std::string{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    };
+    EXPECT_EQ(slurp(csv), slurp(csvAgain));
+
+    // Any flipped byte is caught by the checksums
+    std::string bytes = slurp(snap);
+    bytes[bytes.size() - 3] ^= 0x20;
+    {
+        std::ofstream out(snap, std::ios::binary);
+        out << bytes;
+    }
+    EXPECT_THROW(loaded.LoadSnapshot(snap, pwdA), std::runtime_error);
+
+    std::remove(snap.c_str());
+    std::remove(csv.c_str());
+    std::remove(csvAgain.c_str());
+}
+
+TEST_F(TestBankAccount, JournalRecoversAfterCrashAndTornTail) {
+    const std::string snap = "test_recover.snap";
+    const std::string wal = "test_recover.journal";
+    std::remove(snap.c_str());
+    std::remove(wal.c_str());
+    {
+        BankAccount live("Alice", "BankA", pwdA);
+        live.Recover(snap, wal, pwdA);
+        live.addTransaction(makeIncome(100.0, "salary", "INC-019"));
+        live.addTransaction(makeExpense(30.0, "rent", "EXP-017"));
+        live.Checkpoint(snap, pwdA);
+        live.addTransaction(makeIncome(5.0, "after checkpoint", "INC-020"));
+        // no save: the account is dropped as if the process crashed
+    }
+    {
+        // Half-written record at the end of the journal
+        std::ofstream out(wal, std::ios::binary | std::ios::app);
+        out << "\x40\x00\x00\x00garbage";
+    }
+    const auto tornSize = std::filesystem::file_size(wal);
+
+    BankAccount recovered("Alice", "BankA", pwdA);
+    recovered.Recover(snap, wal, pwdA);
+    EXPECT_EQ(recovered.transactionCount(), 3u);
+    EXPECT_EQ(recovered.balance(), Money::fromCents(7500));
+    ASSERT_TRUE(recovered.findTransactionById("INC-020").has_value());
+    EXPECT_LT(std::filesystem::file_size(wal), tornSize);
+
+    recovered.addTransaction(makeExpense(15.0, "after recovery", "EXP-018"));
+    BankAccount again("Alice", "BankA", pwdA);
+    again.Recover(snap, wal, pwdA);
+    EXPECT_EQ(again.balance(), Money::fromCents(6000));
+
+    std::remove(snap.c_str());
+    std::remove(wal.c_str());
+}
+
+TEST_F(TestBankAccount, JournalGroupsConcurrentCommits) {
+    const std::string wal = "test_group.journal";
+    std::remove(wal.c_str());
+    constexpr int threads = 8;
+    constexpr int perThread = 50;
+    {
+        TransactionJournal journal(wal);
+        std::vector<std::thread> writers;
+        for (int w = 0; w < threads; ++w) {
+            writers.emplace_back([&, w] {
+                for (int i = 0; i < perThread; ++i) {
+                    const std::string id = "W" + std::to_string(w) + "-" + std::to_string(i);
+                    journal.commit(TransactionRecord{id, now, Money::fromCents(100), TransactionKind::Income,
+                                                     "d", "c", "Income", "S", "R"});
+                }
+            });
+        }
+        for (auto& t : writers) t.join();
+        EXPECT_LE(journal.syncCount(), static_cast<std::uint64_t>(threads * perThread));
+    }
+    TransactionJournal reopened(wal);
+    std::size_t seen = 0;
+    EXPECT_EQ(reopened.replay([&](const TransactionRecord&) { ++seen; }), threads * perThread);
+    EXPECT_EQ(seen, static_cast<std::size_t>(threads * perThread));
+    std::remove(wal.c_str());
+}
+
+TEST_F(TestBankAccount, JournalFailureLeavesNoLiveRow) {
+    const std::string wal = "test_failing.journal";
+    std::remove(wal.c_str());
+    accountA->addTransaction(makeIncome(100.0, "salary", "JF-0"));
+    accountA->attachJournal(std::make_shared<TransactionJournal>(wal));
+
+    // The journal file may not grow: the group write fails (EFBIG) after the row was staged
+    rlimit original{};
+    ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &original), 0);
+    const auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+    rlimit limited = original;
+    limited.rlim_cur = std::filesystem::file_size(wal);
+    ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limited), 0);
+    EXPECT_THROW(accountA->addTransaction(makeExpense(30.0, "lost", "JF-1")), std::runtime_error);
+    setrlimit(RLIMIT_FSIZE, &original);
+    std::signal(SIGXFSZ, previousHandler);
+
+    // Nothing of the failed insert stays visible
+    EXPECT_FALSE(accountA->findTransactionById("JF-1").has_value());
+    EXPECT_EQ(accountA->transactionCount(), 1u);
+    EXPECT_EQ(accountA->balance(), Money::fromCents(10000));
+    EXPECT_EQ(accountA->balanceAt(now + hours(1)), Money::fromCents(10000));
+    EXPECT_EQ(accountA->computeSummary().withdrawals, Money{});
+
+    // The failed journal rejects later inserts before they touch the account
+    EXPECT_THROW(accountA->addTransaction(makeExpense(10.0, "later", "JF-2")), std::runtime_error);
+    const std::vector<TransactionRecord> batch{{"JF-3", now, Money::fromCents(100), TransactionKind::Income,
+                                                "d", "c", "Income", "Alice", "Alice"}};
+    EXPECT_THROW(accountA->addTransactions(batch), std::runtime_error);
+    EXPECT_EQ(accountA->transactionCount(), 1u);
+    EXPECT_EQ(accountA->balance(), Money::fromCents(10000));
+    std::remove(wal.c_str());
+}
+
+TEST_F(TestBankAccount, AggregateKernelsMatchScalarLoop) {
+    // Odd length so the vector body leaves a scalar tail
+    constexpr std::size_t n = 1003;
+    std::vector<Money> amounts;
+    std::vector<TransactionKind> kinds;
+    std::vector<std::uint32_t> groups;
+    std::uint64_t seed = 42;
+    for (std::size_t i = 0; i < n; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        amounts.push_back(Money::fromCents(static_cast<std::int64_t>(seed >> 40) - 4'000'000));
+        kinds.push_back((seed >> 7) & 1 ? TransactionKind::Expense : TransactionKind::Income);
+        groups.push_back(static_cast<std::uint32_t>((seed >> 20) % 5));
+    }
+
+    Money deposits, withdrawals, min = Money::fromCents(INT64_MAX), max = Money::fromCents(INT64_MIN);
+    std::size_t negatives = 0;
+    std::vector<Money> expectedGroups(5);
+    for (std::size_t i = 0; i < n; ++i) {
+        const Money v = kinds[i] == TransactionKind::Expense ? -amounts[i] : amounts[i];
+        if (v >= Money{}) deposits += v;
+        else            { withdrawals -= v; ++negatives; }
+        min = std::min(min, v);
+        max = std::max(max, v);
+        expectedGroups[groups[i]] += v;
+    }
+
+    std::vector<Money> fast(5), slow(5);
+    const auto t = aggregate::summarize(amounts, kinds, groups, fast);
+    const auto s = aggregate::summarizeScalar(amounts, kinds, groups, slow);
+    for (const auto& r : {t, s}) {
+        EXPECT_EQ(r.deposits, deposits);
+        EXPECT_EQ(r.withdrawals, withdrawals);
+        EXPECT_EQ(r.balance, deposits - withdrawals);
+        EXPECT_EQ(r.withdrawalCount, negatives);
+        EXPECT_EQ(r.depositCount, n - negatives);
+        EXPECT_EQ(r.minValue, min);
+        EXPECT_EQ(r.maxValue, max);
+    }
+    EXPECT_EQ(fast, expectedGroups);
+    EXPECT_EQ(slow, expectedGroups);
+
+    const auto empty = aggregate::summarize({}, {});
+    EXPECT_EQ(empty.minValue, Money{});
+    EXPECT_EQ(empty.depositCount, 0u);
+}
+
+TEST_F(TestBankAccount, StatisticsGroupByCategory) {
+    accountA->addTransaction(makeIncome(100.0, "salary", "INC-021"));
+    accountA->addTransaction(makeExpense(30.0, "rent", "EXP-019"));
+    accountA->addTransaction(makeExpense(12.5, "more", "EXP-020"));
+
+    const auto stats = accountA->computeStatistics();
+    EXPECT_EQ(stats.totals.balance, accountA->balance());
+    EXPECT_EQ(stats.totals.withdrawals, accountA->computeSummary().withdrawals);
+    EXPECT_EQ(stats.totals.withdrawalCount, 2u);
+    EXPECT_EQ(stats.totals.minValue, Money::fromCents(-3000));
+    EXPECT_EQ(stats.totals.maxValue, Money::fromCents(10000));
+    ASSERT_EQ(stats.byCategory.size(), 2u);
+    EXPECT_EQ(stats.byCategory[0].first, "general");
+    EXPECT_EQ(stats.byCategory[0].second, Money::fromCents(-4250));
+    EXPECT_EQ(stats.byCategory[1].first, "salary");
+    EXPECT_EQ(stats.byCategory[1].second, Money::fromCents(10000));
+}
+
+TEST_F(TestBankAccount, DictionaryEncodesLowCardinalityFields) {
+    StringDictionary& dictionary = StringDictionary::shared();
+    EXPECT_EQ(dictionary[StringDictionary::kTransfer], "Transfer");
+    EXPECT_EQ(dictionary.intern("Income"), StringDictionary::kIncome);
+
+    accountA->addTransaction(makeIncome(10.0, "a", "INC-022"));
+    accountB->addTransaction(std::make_unique<Income>(
+        "INC-023", now, Money::fromCents(500), "b", "salary", "Income", "Alice", "Alice"));
+    // Same strings, same codes, across accounts
+    const auto firstCodes = [](const BankAccount& account) {
+        return account.read([](const TransactionStore& store) {
+            return std::pair(store.categoryCodes()[0], store.operationTypeCodes()[0]);
+        });
+    };
+    EXPECT_EQ(firstCodes(*accountA).first, firstCodes(*accountB).first);
+    EXPECT_EQ(firstCodes(*accountA).second, StringDictionary::kIncome);
+    EXPECT_EQ(accountB->findTransactionById("INC-023")->getCategory(), "salary");
+
+    // Looking up an unknown value neither matches nor grows the dictionary
+    const std::size_t before = dictionary.size();
+    EXPECT_TRUE(accountA->filterByType("NoSuchType").empty());
+    accountA->setSecondaryIndexes(false);
+    EXPECT_TRUE(accountA->filterByCounterparty("NoSuchAccount").empty());
+    EXPECT_EQ(accountA->filterByType("Income").size(), 1u);
+    EXPECT_EQ(dictionary.size(), before);
+
+    // Interning is safe from several threads at once
+    std::vector<std::thread> workers;
+    std::vector<std::uint32_t> codes(4);
+    for (int w = 0; w < 4; ++w) {
+        workers.emplace_back([&, w] {
+            for (int i = 0; i < 1000; ++i) dictionary.intern("acct-" + std::to_string(i));
+            codes[w] = dictionary.intern("acct-999");
+        });
+    }
+    for (auto& t : workers) t.join();
+    EXPECT_EQ(std::count(codes.begin(), codes.end(), codes[0]), 4);
+    EXPECT_EQ(dictionary[codes[0]], "acct-999");
+}
+
+TEST_F(TestBankAccount, TaggedTransactionsMatchPolymorphicApi) {
+    const auto income = makeIncome(12.5, "tip", "INC-024");
+    const auto expense = makeExpense(4.0, "bus", "EXP-021");
+    const Transaction& in = *income;
+    const Transaction& out = *expense;
+    EXPECT_EQ(in.kind(), TransactionKind::Income);
+    EXPECT_EQ(out.kind(), TransactionKind::Expense);
+    EXPECT_EQ(in.value(), in.getValue());
+    EXPECT_EQ(out.value(), out.getValue());
+    EXPECT_EQ(out.getType(), "Expense");
+    static_assert(signedValue<TransactionKind::Expense>(Money::fromCents(7)) == Money::fromCents(-7));
+
+    // Record overload: same rules, no Transaction object
+    accountA->addTransaction(TransactionRecord{"INC-025", now, Money::fromCents(1000), TransactionKind::Income,
+                                               "cash", "salary", "Income", "Alice", "Alice"});
+    EXPECT_THROW(accountA->addTransaction(TransactionRecord{"EXP-022", now, Money::fromCents(1001),
+                                                            TransactionKind::Expense, "too much", "general",
+                                                            "Expense", "Alice", "Alice"}),
+                 std::runtime_error);
+    EXPECT_THROW(accountA->addTransaction(TransactionRecord{"EXP-023", now, Money::fromCents(100),
+                                                            TransactionKind::Expense, "wire", "Transfer",
+                                                            "Expense", "Alice", "Bob"}),
+                 std::invalid_argument);
+    accountA->addTransaction(TransactionRecord{"EXP-024", now, Money::fromCents(100), TransactionKind::Expense,
+                                               "wire", "Transfer", "Expense", "Alice", "Bob"},
+                             accountB.get());
+    EXPECT_EQ(accountA->balance(), Money::fromCents(900));
+    EXPECT_EQ(accountA->transactionCount(), 2u);
+}
+
+TEST_F(TestBankAccount, StoreAllocatesFromAccountResource) {
+    // Forwards to new/delete and keeps track of what is still outstanding
+    struct CountingResource : std::pmr::memory_resource {
+        std::size_t outstanding = 0;
+        std::size_t allocations = 0;
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            outstanding += bytes;
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+            outstanding -= bytes;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    } counting;
+
+    {
+        BankAccount account("Alice", "BankA", pwdA, &counting);
+        EXPECT_EQ(account.read([](const TransactionStore& store) { return store.resource(); }), &counting);
+        for (int i = 0; i < 1000; ++i) {
+            account.addTransaction(makeIncome(1.0, "arena", "ARENA-" + std::to_string(i)));
+        }
+        EXPECT_GT(counting.allocations, 0u);
+        EXPECT_GT(counting.outstanding,
+                  account.read([](const TransactionStore& store) { return store.memoryFootprint(); }) / 2);
+    }
+    EXPECT_EQ(counting.outstanding, 0u);
+
+    // A monotonic arena: the whole history is released when the arena goes away
+    std::pmr::monotonic_buffer_resource arena(1 << 16);
+    BankAccount pooled("Alice", "BankA", pwdA, &arena);
+    for (int i = 0; i < 1000; ++i) {
+        pooled.addTransaction(makeIncome(1.0, "arena", "POOL-" + std::to_string(i)));
+    }
+    EXPECT_EQ(pooled.balance(), Money::fromCents(100000));
+    EXPECT_TRUE(pooled.findTransactionById("POOL-999").has_value());
+}
+
+TEST_F(TestBankAccount, BatchInsertIsAllOrNothing) {
+    accountA->addTransaction(makeIncome(50.0, "seed", "INC-026"));
+    const auto record = [&](std::string_view id, std::int64_t cents, TransactionKind kind, seconds offset) {
+        return TransactionRecord{id, now + offset, Money::fromCents(cents), kind, "batch", "general",
+                                 kind == TransactionKind::Expense ? "Expense" : "Income", "Alice", "Alice"};
+    };
+
+    // Each expense alone fits the balance, together they overdraw it
+    const std::vector<TransactionRecord> overdraft = {
+        record("B-1", 3000, TransactionKind::Expense, seconds(1)),
+        record("B-2", 3000, TransactionKind::Expense, seconds(2)),
+    };
+    EXPECT_THROW(accountA->addTransactions(overdraft), std::runtime_error);
+    const std::vector<TransactionRecord> duplicate = {
+        record("B-3", 100, TransactionKind::Income, seconds(3)),
+        record("B-3", 100, TransactionKind::Income, seconds(4)),
+    };
+    EXPECT_THROW(accountA->addTransactions(duplicate), std::runtime_error);
+    EXPECT_EQ(accountA->transactionCount(), 1u);
+    EXPECT_EQ(accountA->balance(), Money::fromCents(5000));
+
+    // The store itself rolls back a batch that fails half-way
+    TransactionStore store;
+    store.append(record("S-1", 100, TransactionKind::Income, seconds(0)));
+    const std::vector<TransactionRecord> clash = {
+        record("S-2", 100, TransactionKind::Income, seconds(-5)),
+        record("S-1", 100, TransactionKind::Income, seconds(1)),
+    };
+    EXPECT_THROW(store.appendBatch(clash), std::runtime_error);
+    EXPECT_EQ(store.size(), 1u);
+    EXPECT_FALSE(store.containsId("S-2"));
+    EXPECT_EQ(store.rowsByTime().size(), 1u);
+    EXPECT_EQ(store.rowsWithCounterparty("Alice").size(), 1u);
+
+    // Rolling back a large batch leaves the ID index exactly as it was
+    std::vector<std::string> ids;
+    for (int i = 0; i < 3000; ++i) ids.push_back("R-" + std::to_string(i));
+    std::vector<TransactionRecord> big;
+    for (int i = 0; i < 500; ++i) store.append(record(ids[i], 1, TransactionKind::Income, seconds(i)));
+    for (int i = 500; i < 3000; ++i) big.push_back(record(ids[i], 1, TransactionKind::Income, seconds(i)));
+    big.push_back(record(ids[42], 1, TransactionKind::Income, seconds(0)));
+    EXPECT_THROW(store.appendBatch(big), std::runtime_error);
+    for (int i = 0; i < 3000; ++i) ASSERT_EQ(store.containsId(ids[i]), i < 500) << ids[i];
+
+    // Income first funds the expense later in the same batch
+    std::vector<std::unique_ptr<Transaction>> ok;
+    ok.push_back(makeIncome(100.0, "in", "B-4"));
+    ok.push_back(makeExpense(120.0, "out", "B-5"));
+    accountA->addTransactions(ok);
+    EXPECT_EQ(accountA->transactionCount(), 3u);
+    EXPECT_EQ(accountA->balance(), Money::fromCents(3000));
+    EXPECT_EQ(accountA->computeSummary().withdrawals, Money::fromCents(12000));
+    EXPECT_TRUE(accountA->findTransactionById("B-5").has_value());
+}
+
+// Run under ThreadSanitizer as well (-fsanitize=thread, --gtest_filter=*ConcurrentReaders*)
+TEST_F(TestBankAccount, ConcurrentReadersDuringIngestion) {
+    constexpr int writers = 2;
+    constexpr int perWriter = 2000;
+    std::atomic<int> finished{0};
+    std::atomic<bool> inconsistent{false};
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w] {
+            for (int i = 0; i < perWriter; ++i) {
+                accountA->addTransaction(makeIncome(1.0, "stress",
+                                                    "W" + std::to_string(w) + "-" + std::to_string(i)));
+            }
+            ++finished;
+        });
+    }
+    for (int r = 0; r < 3; ++r) {
+        threads.emplace_back([&] {
+            Money last{};
+            while (finished.load() < writers) {
+                // Only incomes: the balance never goes back
+                const Money now = accountA->balance();
+                if (now < last) inconsistent = true;
+                last = now;
+
+                const auto stats = accountA->computeStatistics();
+                if (stats.totals.deposits - stats.totals.withdrawals != stats.totals.balance) inconsistent = true;
+
+                accountA->read([&](const TransactionStore& store) {
+                    if (store.rowsByTime().size() != store.size()) inconsistent = true;
+                    if (!store.empty() && store[store.size() - 1].getDescription() != "stress") inconsistent = true;
+                });
+                if (accountA->filterByType("Income").size() > static_cast<std::size_t>(writers * perWriter)) {
+                    inconsistent = true;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    EXPECT_FALSE(inconsistent.load());
+    EXPECT_EQ(accountA->transactionCount(), static_cast<std::size_t>(writers * perWriter));
+    EXPECT_EQ(accountA->balance(), Money::fromCents(100 * writers * perWriter));
+    EXPECT_EQ(accountA->computeStatistics().totals.balance, accountA->balance());
+    EXPECT_EQ(accountA->filterByType("Income").size(), static_cast<std::size_t>(writers * perWriter));
+
+    // The single-mutex baseline gives the same results
+    accountB->setConcurrencyMode(ConcurrencyMode::Exclusive);
+    EXPECT_EQ(accountB->concurrencyMode(), ConcurrencyMode::Exclusive);
+    accountB->addTransaction(makeIncome(5.0, "exclusive", "EX-1"));
+    EXPECT_EQ(accountB->read([](const TransactionStore& store) { return store.size(); }), 1u);
+    EXPECT_EQ(accountB->balance(), Money::fromCents(500));
+}
+
+TEST_F(TestBankAccount, LedgerTransfersAreAtomic) {
+    Ledger ledger;
+    BankAccount& a = ledger.openAccount("Alice", "IT0001", pwdA);
+    BankAccount& b = ledger.openAccount("Bob", "IT0002", pwdB);
+    EXPECT_THROW(ledger.openAccount("Carol", "IT0001", "x"), std::runtime_error);
+    EXPECT_EQ(ledger.size(), 2u);
+    EXPECT_EQ(ledger.find("IT0002"), &b);
+    EXPECT_EQ(ledger.find("IT9999"), nullptr);
+
+    a.addTransaction(makeIncome(100.0, "seed", "SEED-A"));
+    ledger.transfer("IT0001", "IT0002", Money::fromCents(3000), "TRF-1", "rent");
+    EXPECT_EQ(a.balance(), Money::fromCents(7000));
+    EXPECT_EQ(b.balance(), Money::fromCents(3000));
+    const auto out = a.findTransactionById("TRF-1-OUT");
+    ASSERT_TRUE(out.has_value());
+    EXPECT_EQ(out->getKind(), TransactionKind::Expense);
+    EXPECT_EQ(out->getReceiverAccount(), "IT0002");
+    EXPECT_EQ(b.findTransactionById("TRF-1-IN")->getCategory(), "Transfer");
+
+    // Failures leave both sides untouched
+    EXPECT_THROW(ledger.transfer("IT0001", "IT0002", Money::fromCents(9000), "TRF-2", "too much"),
+                 std::runtime_error);
+    EXPECT_THROW(ledger.transfer("IT0001", "IT9999", Money::fromCents(100), "TRF-3", "nowhere"),
+                 std::invalid_argument);
+    EXPECT_THROW(ledger.transfer("IT0001", "IT0001", Money::fromCents(100), "TRF-4", "self"),
+                 std::runtime_error);
+    EXPECT_THROW(ledger.transfer("IT0001", "IT0002", Money{}, "TRF-5", "zero"), std::runtime_error);
+    b.addTransaction(TransactionRecord{"TRF-6-IN", now, Money::fromCents(1), TransactionKind::Income,
+                                       "clash", "general", "Income", "Bob", "Bob"});
+    EXPECT_THROW(ledger.transfer("IT0001", "IT0002", Money::fromCents(100), "TRF-6", "dup"),
+                 std::runtime_error);
+    EXPECT_FALSE(a.findTransactionById("TRF-6-OUT").has_value());
+    EXPECT_EQ(a.transactionCount(), 2u);
+    EXPECT_EQ(a.balance(), Money::fromCents(7000));
+    EXPECT_EQ(b.balance(), Money::fromCents(3001));
+
+    // Opposite transfers on the same pair and disjoint pairs run concurrently;
+    // money is only moved, never created or lost
+    for (int i = 0; i < 4; ++i) {
+        BankAccount& extra = ledger.openAccount("Pool", "POOL-" + std::to_string(i), "x");
+        extra.addTransaction(makeIncome(100.0, "seed", "SEED-P" + std::to_string(i)));
+    }
+    const Money total = ledger.totalBalance();
+    const auto worker = [&](std::string from, std::string to, std::string tag) {
+        for (int i = 0; i < 300; ++i) {
+            ledger.transfer(from, to, Money::fromCents(1), tag + std::to_string(i), "ping");
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.emplace_back(worker, "IT0001", "IT0002", "AB-");
+    threads.emplace_back(worker, "IT0002", "IT0001", "BA-");
+    threads.emplace_back(worker, "POOL-0", "POOL-1", "P01-");
+    threads.emplace_back(worker, "POOL-2", "POOL-3", "P23-");
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(ledger.totalBalance(), total);
+    EXPECT_EQ(a.balance(), Money::fromCents(7000));
+    EXPECT_EQ(ledger.find("POOL-1")->balance(), Money::fromCents(10300));
+    EXPECT_EQ(a.transactionCount(), 602u);
+}
+
+TEST_F(TestBankAccount, LedgerTransferJournalIsAllOrNothing) {
+    const std::string walA = "test_ledger_a.journal";
+    const std::string walB = "test_ledger_b.journal";
+    const std::string walT = "test_ledger_transfers.journal";
+    for (const auto& file : {walA, walB, walT}) std::remove(file.c_str());
+    // Runs f while file may not grow: its next group write fails (EFBIG)
+    const auto frozen = [](const std::string& file, const std::function<void()>& f) {
+        rlimit original{};
+        ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &original), 0);
+        const auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit limited = original;
+        limited.rlim_cur = std::filesystem::file_size(file);
+        ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limited), 0);
+        f();
+        setrlimit(RLIMIT_FSIZE, &original);
+        std::signal(SIGXFSZ, previousHandler);
+    };
+
+    {
+        Ledger ledger;
+        BankAccount& a = ledger.openAccount("Alice", "IT0001", pwdA);
+        BankAccount& b = ledger.openAccount("Bob", "IT0002", pwdB);
+        a.attachJournal(std::make_shared<TransactionJournal>(walA));
+        b.attachJournal(std::make_shared<TransactionJournal>(walB));
+        a.addTransaction(makeIncome(100.0, "seed", "SEED-A"));
+
+        // Two account journals have no common commit: journaled accounts need the ledger journal
+        EXPECT_THROW(ledger.transfer("IT0001", "IT0002", Money::fromCents(100), "TRF-0", "none"),
+                     std::runtime_error);
+        EXPECT_EQ(a.balance(), Money::fromCents(10000));
+        ledger.attachJournal(std::make_shared<TransactionJournal>(walT));
+        ledger.transfer("IT0001", "IT0002", Money::fromCents(3000), "TRF-1", "rent");
+
+        // The receiver's own journal fails: both legs still travel in the ledger record
+        frozen(walB, [&] {
+            EXPECT_THROW(b.addTransaction(makeIncome(1.0, "lost", "B-LOST")), std::runtime_error);
+        });
+        ledger.transfer("IT0001", "IT0002", Money::fromCents(1000), "TRF-2", "bills");
+
+        // The ledger journal fails: neither leg stays, in memory or on disk
+        frozen(walT, [&] {
+            EXPECT_THROW(ledger.transfer("IT0001", "IT0002", Money::fromCents(500), "TRF-3", "lost"),
+                         std::runtime_error);
+        });
+        EXPECT_FALSE(a.findTransactionById("TRF-3-OUT").has_value());
+        EXPECT_FALSE(b.findTransactionById("TRF-3-IN").has_value());
+        EXPECT_EQ(a.balance(), Money::fromCents(6000));
+        EXPECT_EQ(b.balance(), Money::fromCents(4000));
+    }
+
+    // Restart: each account from its own journal, then the transfers from the ledger journal
+    Ledger ledger;
+    BankAccount& a = ledger.openAccount("Alice", "IT0001", pwdA);
+    BankAccount& b = ledger.openAccount("Bob", "IT0002", pwdB);
+    a.Recover("test_ledger_missing.snapshot", walA, pwdA);
+    b.Recover("test_ledger_missing.snapshot", walB, pwdB);
+    ledger.Recover(walT);
+    EXPECT_EQ(a.balance(), Money::fromCents(6000));
+    EXPECT_EQ(b.balance(), Money::fromCents(4000));
+    EXPECT_TRUE(b.findTransactionById("TRF-2-IN").has_value());
+    EXPECT_FALSE(a.findTransactionById("TRF-3-OUT").has_value());
+    EXPECT_FALSE(b.findTransactionById("B-LOST").has_value());
+    EXPECT_EQ(ledger.totalBalance(), Money::fromCents(10000));
+
+    // A checkpoint moves the legs into the account snapshots and empties the ledger journal
+    const std::string snapA = "test_ledger_a.snapshot";
+    const std::string snapB = "test_ledger_b.snapshot";
+    ledger.Checkpoint([&](BankAccount& account) {
+        account.SaveSnapshot(&account == &a ? snapA : snapB, &account == &a ? pwdA : pwdB);
+    });
+    EXPECT_EQ(std::filesystem::file_size(walT), 8u);     // only the magic is left
+    for (const auto& file : {walA, walB, walT, snapA, snapB}) std::remove(file.c_str());
+}
+
+TEST_F(TestBankAccount, QueryViewsComposeAndPage) {
+    // Rows arrive out of time order, with a few categories, types and amounts
+    const char* categories[] = {"Groceries", "Rent", "Fun"};
+    std::vector<std::string> ids;
+    for (int i = 0; i < 300; ++i) ids.push_back("Q-" + std::to_string(i));
+    accountA->addTransaction(makeIncome(10000.0, "seed", "Q-SEED"));
+    for (int i = 0; i < 300; ++i) {
+        const bool expense = i % 3 != 0;
+        accountA->addTransaction(TransactionRecord{
+            ids[i], now + seconds((i * 37) % 300), Money::fromCents(100 + (i * 53) % 1000),
+            expense ? TransactionKind::Expense : TransactionKind::Income, "q", categories[i % 3],
+            expense ? "Expense" : "Income", "Alice", i % 5 == 0 ? "Bob" : "Alice"});
+    }
+
+    // Reference: full scan in time order with the same conditions
+    const auto reference = [&](auto pred) {
+        std::vector<std::string> out;
+        for (const auto& t : accountA->getSortedTransactions()) {
+            if (pred(t)) out.emplace_back(t.getId());
+        }
+        return out;
+    };
+    const auto idsOf = [](const std::vector<TransactionRow>& rows) {
+        std::vector<std::string> out;
+        for (const auto& t : rows) out.emplace_back(t.getId());
+        return out;
+    };
+
+    const auto groceries = reference([](const TransactionRow& t) {
+        return t.getCategory() == "Groceries" && t.getAmount() >= Money::fromCents(300) &&
+               t.getAmount() <= Money::fromCents(800);
+    });
+    auto q = TransactionQuery().category("Groceries").minAmount(Money::fromCents(300)).maxAmount(Money::fromCents(800));
+    EXPECT_EQ(idsOf(accountA->select(q)), groceries);
+
+    // Pagination and "latest N" stream straight from the time order
+    const auto page = idsOf(accountA->select(TransactionQuery(q).offset(10).limit(5)));
+    EXPECT_EQ(page, std::vector<std::string>(groceries.begin() + 10, groceries.begin() + 15));
+    auto latest = idsOf(accountA->select(TransactionQuery(q).newestFirst().limit(7)));
+    std::vector<std::string> expectedLatest(groceries.rbegin(), groceries.rbegin() + 7);
+    EXPECT_EQ(latest, expectedLatest);
+
+    const auto bobInWindow = reference([&](const TransactionRow& t) {
+        return (t.getSenderAccount() == "Bob" || t.getReceiverAccount() == "Bob") && t.getType() == "Expense" &&
+               t.getData() >= now + seconds(50) && t.getData() < now + seconds(250);
+    });
+    EXPECT_EQ(idsOf(accountA->select(TransactionQuery().counterparty("Bob").type("Expense")
+                                          .between(now + seconds(50), now + seconds(250)))),
+              bobInWindow);
+
+    // Top-N by amount matches a full stable sort
+    auto all = accountA->getSortedTransactions();
+    std::ranges::stable_sort(all, std::ranges::greater{}, &TransactionRow::getAmount);
+    std::vector<std::string> top(10);
+    std::ranges::transform(all.begin(), all.begin() + 10, top.begin(),
+                           [](const TransactionRow& t) { return std::string(t.getId()); });
+    EXPECT_EQ(idsOf(accountA->select(TransactionQuery().orderBy(QueryOrder::LargestAmount).limit(10))), top);
+    const auto smallest = accountA->select(TransactionQuery().orderBy(QueryOrder::SmallestAmount).offset(2).limit(3));
+    ASSERT_EQ(smallest.size(), 3u);
+    EXPECT_LE(smallest[0].getAmount(), smallest[1].getAmount());
+    EXPECT_LE(smallest[1].getAmount(), smallest[2].getAmount());
+
+    // The lazy range stops as soon as the limit is reached
+    std::size_t streamed = 0;
+    EXPECT_EQ(accountA->query(TransactionQuery().type("Income").limit(4),
+                              [&](const TransactionView& t) { EXPECT_EQ(t.getType(), "Income"); ++streamed; }),
+              4u);
+    EXPECT_EQ(streamed, 4u);
+    accountA->read([&](const TransactionStore& store) {
+        std::size_t n = 0;
+        for (const auto row : TransactionQuery().category("Rent").newestFirst().limit(3).rows(store)) {
+            EXPECT_EQ(store.category(row), "Rent");
+            ++n;
+        }
+        EXPECT_EQ(n, 3u);
+    });
+    EXPECT_TRUE(accountA->select(TransactionQuery().category("NoSuchCategory")).empty());
+    accountA->read([](const TransactionStore& store) {
+        EXPECT_THROW((void) TransactionQuery().orderBy(QueryOrder::LargestAmount).rows(store),
+                     std::runtime_error);
+    });
+}
+
+TEST_F(TestBankAccount, PlannerPicksMostSelectiveIndex) {
+    accountA->addTransaction(makeIncome(100000.0, "seed", "P-SEED"));
+    std::vector<std::string> ids;
+    for (int i = 0; i < 1000; ++i) ids.push_back("P-" + std::to_string(i));
+    for (int i = 0; i < 1000; ++i) {
+        // "Refund" is rare, "Carol" appears in 1 row out of 100
+        const bool refund = i % 250 == 0;
+        accountA->addTransaction(TransactionRecord{
+            ids[i], now + seconds(1000 - i), Money::fromCents(100 + i), refund ? TransactionKind::Income
+                                                                             : TransactionKind::Expense,
+            i % 2 ? "card payment" : "wire", i % 3 ? "Shopping" : "Bills", refund ? "Refund" : "Expense",
+            "Alice", i % 100 == 7 ? "Carol" : "Shop-" + std::to_string(i % 4)});
+    }
+
+    const auto brute = [&](auto pred) {
+        std::vector<std::string> out;
+        for (const auto& t : accountA->getSortedTransactions()) {
+            if (pred(t)) out.emplace_back(t.getId());
+        }
+        return out;
+    };
+    const auto idsOf = [](const std::vector<TransactionRow>& rows) {
+        std::vector<std::string> out;
+        for (const auto& t : rows) out.emplace_back(t.getId());
+        return out;
+    };
+
+    // The type index (4 rows) beats the counterparty index and the full scan
+    auto q = TransactionQuery().type("Refund").where(QueryField::Sender, "Alice");
+    auto plan = accountA->explain(q);
+    EXPECT_EQ(plan.access, "index type='Refund'");
+    EXPECT_EQ(plan.candidates, 4u);
+    EXPECT_EQ(plan.examined, 4u);
+    EXPECT_EQ(plan.matched, 4u);
+    EXPECT_EQ(idsOf(accountA->select(q)),
+              brute([](const TransactionRow& t) { return t.getOperationType() == "Refund"; }));
+
+    // Counterparty index, then residual prefix and range conditions on the candidates only
+    q = TransactionQuery().counterparty("Carol").wherePrefix(QueryField::Description, "card")
+            .minAmount(Money::fromCents(500)).newestFirst();
+    plan = accountA->explain(q);
+    EXPECT_EQ(plan.access, "index counterparty='Carol'");
+    EXPECT_EQ(plan.examined, 10u);
+    EXPECT_EQ(idsOf(accountA->select(q)).size(), plan.matched);
+    auto expected = brute([](const TransactionRow& t) {
+        return t.getReceiverAccount() == "Carol" && t.getDescription().starts_with("card") &&
+               t.getAmount() >= Money::fromCents(500);
+    });
+    std::ranges::reverse(expected);
+    EXPECT_EQ(idsOf(accountA->select(q)), expected);
+
+    // A narrow time range wins over a broad index
+    q = TransactionQuery().type("Expense").between(now + seconds(10), now + seconds(20));
+    plan = accountA->explain(q);
+    EXPECT_EQ(plan.access, "time range");
+    EXPECT_EQ(plan.candidates, 10u);
+    EXPECT_EQ(idsOf(accountA->select(q)), brute([&](const TransactionRow& t) {
+        return t.getOperationType() == "Expense" && t.getData() >= now + seconds(10) &&
+               t.getData() < now + seconds(20);
+    }));
+
+    // ID lookup, prefix on dictionary fields, and a full scan that stops at the limit
+    plan = accountA->explain(TransactionQuery().id("P-42").category("Bills"));
+    EXPECT_EQ(plan.access, "id 'P-42'");
+    EXPECT_EQ(plan.matched, 1u);
+    EXPECT_EQ(accountA->select(TransactionQuery().wherePrefix(QueryField::Receiver, "Shop-")).size(),
+              brute([](const TransactionRow& t) { return t.getReceiverAccount().starts_with("Shop-"); }).size());
+    plan = accountA->explain(TransactionQuery().category("Bills").limit(5));
+    EXPECT_EQ(plan.access, "full scan");
+    EXPECT_EQ(plan.returned, 5u);
+    EXPECT_LT(plan.examined, 20u);
+
+    // Without secondary indexes the planner falls back to the time order
+    accountA->setSecondaryIndexes(false);
+    plan = accountA->explain(TransactionQuery().type("Refund"));
+    EXPECT_EQ(plan.access, "full scan");
+    EXPECT_EQ(plan.matched, 4u);
+    accountA->setSecondaryIndexes(true);
+}
+
+TEST_F(TestBankAccount, RollupsTrackEveryInsert) {
+    const TimePoint jan1 = sys_days{year{2026} / 1 / 1};
+    const char* categories[] = {"Groceries", "Rent", "Salary"};
+    accountA->addTransaction(TransactionRecord{"R-SEED", jan1, Money::fromCents(10000000), TransactionKind::Income,
+                                               "seed", "Salary", "Income", "Alice", "Alice"});
+    std::vector<std::string> ids;
+    for (int i = 0; i < 400; ++i) ids.push_back("R-" + std::to_string(i));
+    std::vector<TransactionRecord> batch;
+    for (int i = 0; i < 400; ++i) {
+        // ~3 months, out of order; the second half goes in as one batch
+        const TransactionRecord r{ids[i], jan1 + hours((i * 7919) % (24 * 90)), Money::fromCents(100 + i),
+                                  i % 4 ? TransactionKind::Expense : TransactionKind::Income, "r",
+                                  categories[i % 3], i % 4 ? "Expense" : "Income", "Alice", "Alice"};
+        if (i < 200) accountA->addTransaction(r);
+        else         batch.push_back(r);
+    }
+    accountA->addTransactions(batch);
+
+    const auto brute = [&](TimePoint from, TimePoint to) {
+        std::map<std::string, std::pair<Money, Money>> out;
+        for (const auto& t : accountA->getSortedTransactions()) {
+            if (t.getData() < from || t.getData() >= to) continue;
+            auto& [income, expense] = out[std::string(t.getCategory())];
+            (t.getKind() == TransactionKind::Income ? income : expense) += t.getAmount();
+        }
+        return out;
+    };
+    const auto check = [&](TimePoint from, TimePoint to) {
+        const auto expected = brute(from, to);
+        const auto got = accountA->categoryTotals(from, to);
+        ASSERT_EQ(got.size(), expected.size());
+        for (const auto& c : got) {
+            EXPECT_EQ(c.income, expected.at(c.category).first) << c.category;
+            EXPECT_EQ(c.expense, expected.at(c.category).second) << c.category;
+        }
+    };
+    // Whole months, a range that spans month edges, and a single day
+    check(jan1, sys_days{year{2026} / 4 / 1});
+    check(sys_days{year{2026} / 1 / 20}, sys_days{year{2026} / 3 / 5});
+    check(sys_days{year{2026} / 2 / 10}, sys_days{year{2026} / 2 / 11});
+
+    const auto months = accountA->rollups(RollupPeriod::Month, jan1, sys_days{year{2026} / 4 / 1});
+    std::uint64_t rows = 0;
+    Money salaryIncome{};
+    for (const auto& r : months) {
+        rows += r.count;
+        if (r.category == "Salary" && r.kind == TransactionKind::Income) salaryIncome += r.sum;
+    }
+    EXPECT_EQ(rows, 401u);
+    EXPECT_EQ(salaryIncome, brute(jan1, sys_days{year{2026} / 4 / 1}).at("Salary").first);
+    EXPECT_LE(months.size(), 3u * 3u * 2u);
+    EXPECT_EQ(months.front().start, jan1);
+    const auto february = accountA->rollups(RollupPeriod::Day, sys_days{year{2026} / 2 / 1},
+                                            sys_days{year{2026} / 3 / 1});
+    for (const auto& r : february) {
+        EXPECT_GE(r.start, sys_days{year{2026} / 2 / 1});
+        EXPECT_LT(r.start, sys_days{year{2026} / 3 / 1});
+    }
+
+    // A reload rebuilds the same buckets once
+    const std::string file = "test_rollups.csv";
+    accountA->SaveToFile(file, pwdA);
+    BankAccount reloaded("Alice", "BankA", pwdA);
+    reloaded.ReadFromFile(file, pwdA);
+    const auto again = reloaded.rollups(RollupPeriod::Month, jan1, sys_days{year{2026} / 4 / 1});
+    ASSERT_EQ(again.size(), months.size());
+    for (std::size_t i = 0; i < months.size(); ++i) {
+        EXPECT_EQ(again[i].sum, months[i].sum);
+        EXPECT_EQ(again[i].count, months[i].count);
+    }
+    std::remove(file.c_str());
+}
+
+TEST_F(TestBankAccount, BalanceAsOfMatchesPrefixScan) {
+    const TimePoint t0 = sys_days{year{2026} / 1 / 1};
+    accountA->addTransaction(TransactionRecord{"H-SEED", t0, Money::fromCents(100000000), TransactionKind::Income,
+                                               "seed", "Salary", "Income", "Alice", "Alice"});
+    std::vector<std::string> ids;
+    for (int i = 0; i < 3000; ++i) ids.push_back("H-" + std::to_string(i));
+    std::vector<TransactionRecord> batch;
+    for (int i = 0; i < 3000; ++i) {
+        // Pseudo-random timestamps (many late arrivals and equal timestamps)
+        const TransactionRecord r{ids[i], t0 + minutes((i * 7877) % 5000), Money::fromCents(1 + (i * 31) % 5000),
+                                  i % 3 ? TransactionKind::Expense : TransactionKind::Income, "h", "general",
+                                  i % 3 ? "Expense" : "Income", "Alice", "Alice"};
+        if (i < 2000) accountA->addTransaction(r);
+        else          batch.push_back(r);
+    }
+    accountA->addTransactions(batch);
+
+    const auto scan = [&](TimePoint from, TimePoint to) {
+        BankAccount::Summary s;
+        for (const auto& t : accountA->getSortedTransactions()) {
+            if (t.getData() < from || t.getData() >= to) continue;
+            const Money v = t.getValue();
+            if (v >= Money{}) s.deposits += v;
+            else              s.withdrawals += -v;
+            s.balance += v;
+        }
+        return s;
+    };
+    const TimePoint start = TimePoint::min();
+    for (int m = -1; m <= 5001; m += 97) {
+        const TimePoint t = t0 + minutes(m);
+        EXPECT_EQ(accountA->balanceAt(t), scan(start, t + nanoseconds(1)).balance) << m;
+        const auto window = accountA->summaryBetween(t, t + minutes(250));
+        const auto expected = scan(t, t + minutes(250));
+        EXPECT_EQ(window.deposits, expected.deposits) << m;
+        EXPECT_EQ(window.withdrawals, expected.withdrawals) << m;
+        EXPECT_EQ(window.balance, expected.balance) << m;
+    }
+    EXPECT_EQ(accountA->balanceAt(t0 + hours(1000)), accountA->balance());
+    EXPECT_EQ(accountA->balanceAt(t0 - seconds(1)), Money{});
+    EXPECT_EQ(accountA->summaryBetween(t0 + hours(2), t0).balance, Money{});
+
+    // The bulk rebuild after a reload answers the same
+    const std::string file = "test_balance_at.csv";
+    accountA->SaveToFile(file, pwdA);
+    BankAccount reloaded("Alice", "BankA", pwdA);
+    reloaded.ReadFromFile(file, pwdA);
+    for (int m = 0; m <= 5000; m += 331) {
+        EXPECT_EQ(reloaded.balanceAt(t0 + minutes(m)), accountA->balanceAt(t0 + minutes(m))) << m;
+    }
+    std::remove(file.c_str());
+}
+
+TEST_F(TestBankAccount, ReportRendererStreamsToAnySink) {
+    const TimePoint t0 = sys_days{year{2026} / 3 / 14} + hours(9) + minutes(26) + milliseconds(535);
+    accountA->addTransaction(TransactionRecord{"R-1", t0, Money::fromCents(150000), TransactionKind::Income,
+                                               "March salary", "Salary", "Income", "Alice", "Alice"});
+    accountA->addTransaction(TransactionRecord{"R-2", t0 + hours(2), Money::fromCents(4250), TransactionKind::Expense,
+                                               "tab\there\nnew line \\ slash", "Food", "Expense", "Alice", "Shop"});
+
+    // Pretty output is byte-identical to the historical std::format layout
+    const auto pretty = [](const TransactionRow& t) {
+        return std::format("ID: {}\nDate: {}\nAmount: {}\nOperation: {}\nCategory: {}\nDescription: {}\n"
+                           "Sender: {}\nReceiver: {}\n\n",
+                           t.getId(), t.getDataFormatted().substr(0, 19), t.getAmount().toString(),
+                           t.getOperationType(), t.getCategory(), t.getDescription(), t.getSenderAccount(),
+                           t.getReceiverAccount());
+    };
+    std::string expected = "\n--- Transaction List ---\n";
+    for (const auto& t : accountA->getSortedTransactions()) expected += pretty(t);
+    expected += "----------------------------------------------\n"
+                "Total Deposits: \x1b[38;2;0;100;0m1500.00\x1b[0m\n"
+                " Total Withdrawals: \x1b[38;2;139;0;0m42.50\x1b[0m\nBalance: 1457.50\n";
+    std::string text;
+    StringSink toString(text);
+    accountA->renderTransactions(toString);
+    EXPECT_EQ(text, expected);
+
+    testing::internal::CaptureStdout();
+    accountA->printTransactions();
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), expected);
+
+    // Colour is optional
+    std::string plain;
+    StringSink toPlain(plain);
+    accountA->renderTransactions(toPlain, {.color = false});
+    EXPECT_EQ(plain.find('\x1b'), std::string::npos);
+    EXPECT_NE(plain.find("Total Deposits: 1500.00\n"), std::string::npos);
+
+    // Compact: one escaped line per row plus the summary
+    std::string compact;
+    StringSink toCompact(compact);
+    accountA->renderTransactions(toCompact, {.format = ReportFormat::Compact});
+    EXPECT_EQ(compact,
+              "R-1\t2026-03-14 09:26:00\tIncome\t1500.00\tSalary\tIncome\tAlice\tAlice\tMarch salary\n"
+              "R-2\t2026-03-14 11:26:00\tExpense\t42.50\tFood\tExpense\tAlice\tShop\t"
+              "tab\\there\\nnew line \\\\ slash\n"
+              "#summary\t1500.00\t42.50\t1457.50\n");
+
+    // Queries: empty results, wrong password, file descriptor sink, tiny buffer
+    std::string none;
+    StringSink toNone(none);
+    EXPECT_EQ(accountA->render(pwdA, TransactionQuery().type("Transfer"), toNone), 0u);
+    EXPECT_EQ(none, "No transactions found\n");
+    EXPECT_THROW(accountA->render("wrong", TransactionQuery(), toNone), std::runtime_error);
+
+    std::string queried;
+    StringSink toQueried(queried);
+    EXPECT_EQ(accountA->render(pwdA, TransactionQuery().category("Food"), toQueried), 1u);
+    EXPECT_EQ(queried, pretty(*accountA->findTransactionById("R-2")));
+
+    const std::string file = "test_report.txt";
+    const int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    FdSink toFile(fd);
+    accountA->renderTransactions(toFile, {.format = ReportFormat::Compact, .bufferSize = 8});
+    ::close(fd);
+    std::ifstream in(file, std::ios::binary);
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(in), {}), compact);
+    std::remove(file.c_str());
+
+    // The sink runs without the account lock: it may even write to the same account
+    struct InsertingSink final : ReportSink {
+        BankAccount& account;
+        std::string text;
+        int writes = 0;
+        explicit InsertingSink(BankAccount& a) : account(a) {}
+        void write(std::string_view bytes) override {
+            text.append(bytes);
+            account.addTransaction(TransactionRecord{"R-SINK-" + std::to_string(writes++),
+                                                     sys_days{year{2026} / 3 / 15}, Money::fromCents(1),
+                                                     TransactionKind::Income, "sink", "Misc", "Income", "Alice",
+                                                     "Alice"});
+        }
+    };
+    InsertingSink inserting(*accountA);
+    accountA->renderTransactions(inserting, {.format = ReportFormat::Compact, .bufferSize = 8});
+    EXPECT_EQ(inserting.text, compact);
+    EXPECT_EQ(accountA->transactionCount(), 2u + static_cast<std::size_t>(inserting.writes));
+}
+
+TEST_F(TestBankAccount, GeneratorIsDeterministicAndRoundTrips) {
+    LedgerGenerator::Options options;
+    options.seed = 7;
+    options.accounts = 4;
+    options.transactions = 2000;
+    options.counterparties = 50;
+    options.span = days{30};
+    const LedgerGenerator generator(options);
+    ASSERT_EQ(generator.accountCount(), 4u);
+
+    const auto slurp = [](const std::string& name) {
+        std::ifstream in(name, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+
+    // Same options (and any thread count) -> same bytes; another seed -> other data
+    const std::string dir = "test_generated_ledger";
+    const auto stats = generator.writeAll(dir, 2);
+    EXPECT_EQ(stats.rows, options.transactions + stats.topUps);
+    EXPECT_EQ(stats.transferLegs, 200u);
+    const std::string file = dir + "/" + generator.bank(1) + ".csv";
+    const std::string generated = slurp(file);
+    const std::string again = "test_generated_again.csv";
+    EXPECT_EQ(LedgerGenerator(options).writeCsv(1, again).bytes, generated.size());
+    EXPECT_EQ(slurp(again), generated);
+    options.seed = 8;
+    LedgerGenerator(options).writeCsv(1, again);
+    EXPECT_NE(slurp(again), generated);
+
+    // The CSV is exactly the SaveToFile dialect: load + save gives the same bytes
+    BankAccount loaded(generator.owner(1), generator.bank(1), pwdA);
+    loaded.ReadFromFile(file, pwdA);
+    loaded.SaveToFile(again, pwdA);
+    EXPECT_EQ(slurp(again), generated);
+
+    // Feeding in memory produces the same account, with a balance that never goes negative
+    BankAccount fed(generator.owner(1), generator.bank(1), pwdA);
+    const auto fedStats = generator.feed(1, fed, pwdA);
+    EXPECT_EQ(fed.transactionCount(), fedStats.rows);
+    EXPECT_EQ(fed.balance(), loaded.balance());
+    fed.SaveToFile(again, pwdA);
+    EXPECT_EQ(slurp(again), generated);
+    Money running;
+    for (const auto& t : fed.getSortedTransactions()) {
+        running += t.getValue();
+        ASSERT_GE(running, Money{}) << t.getId();
+    }
+
+    // Ledger: every transfer has both legs, same amount, on two different generated accounts
+    Ledger ledger;
+    const auto total = generator.populate(ledger, pwdA);
+    EXPECT_EQ(total.rows, stats.rows);
+    EXPECT_EQ(ledger.size(), 4u);
+    EXPECT_EQ(ledger.totalBalance(), total.deposits - total.withdrawals);
+    std::map<std::string, Money> outLegs, inLegs;
+    ledger.forEach([&](BankAccount& account) {
+        for (const auto& t : account.filterByType("Expense")) {
+            if (t.getCategory() == "Transfer") outLegs[std::string(t.getId()).substr(0, t.getId().size() - 4)] = t.getAmount();
+        }
+        for (const auto& t : account.filterByType("Income")) {
+            if (t.getCategory() == "Transfer") inLegs[std::string(t.getId()).substr(0, t.getId().size() - 3)] = t.getAmount();
+        }
+    });
+    EXPECT_EQ(outLegs.size(), 100u);
+    EXPECT_EQ(outLegs, inLegs);
+
+    EXPECT_THROW(LedgerGenerator({.accounts = 0}), std::invalid_argument);
+    std::filesystem::remove_all(dir);
+    std::remove(again.c_str());
+}